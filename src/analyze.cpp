@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lib/analysis/analysis.hpp"
+#include "lib/rom/rom.hpp"
+#include "lib/utils/format.hpp"
+
+// One line per ROM, so a corpus can be filtered with grep before running it in bulk
+static void report(const std::string& path, const ProgramAnalysis& a, TextBuffer& out) {
+    out.put(path).put(": engine=").put(engine_name(fastest_safe_engine(a)));
+    out.put(" code=").put_dec(a.code_bytes).put('/').put_dec(a.image_bytes);
+    out.put(" instructions=").put_dec(a.instructions).put(" functions=").put_dec(a.functions);
+    out.put(" stack=");
+    if (a.max_stack_depth == ANALYSIS_UNBOUNDED) out.put("recursive");
+    else out.put_dec(a.max_stack_depth).put('/').put_dec(ANALYSIS_STACK_LIMIT);
+    // Writes merged into regions; '!' marks a region that overlaps code
+    std::vector<MemoryWrite> regions = a.writes;
+    std::sort(regions.begin(), regions.end(),
+        [](const MemoryWrite& x, const MemoryWrite& y) { return x.first < y.first; });
+    size_t n = 0;
+    for (const MemoryWrite& w : regions) {
+        if (n && w.first <= regions[n - 1].last + 1) {
+            regions[n - 1].last = std::max(regions[n - 1].last, w.last);
+            regions[n - 1].overlaps_code |= w.overlaps_code;
+        } else {
+            regions[n++] = w;
+        }
+    }
+    regions.resize(n);
+    out.put(" writes=");
+    if (regions.empty()) out.put("none");
+    for (size_t i = 0; i < regions.size(); i++) {
+        if (i) out.put(',');
+        out.put_hex(regions[i].first, 3).put('-').put_hex(regions[i].last, 3);
+        if (regions[i].overlaps_code) out.put('!');
+    }
+    out.put(" smc=").put(a.self_modifying ? "maybe" : "no");
+    out.put(" complete=").put(a.complete ? "yes" : "no");
+    out.put(" quirks=").put(quirk_names(a.quirks)).put('\n');
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <rom>...\n";
+        return 1;
+    }
+    std::ios::sync_with_stdio(false);
+    TextBuffer out;
+    int failures = 0;
+    for (int i = 1; i < argc; i++) {
+        try {
+            MappedRom rom(argv[i]);
+            report(argv[i], analyze_program(rom.data(), rom.size()), out);
+        } catch (const std::runtime_error& e) {
+            std::cerr << argv[i] << ": " << e.what() << "\n";
+            failures++;
+        }
+        if (out.size() >= LISTING_FLUSH_SIZE) out.flush(std::cout);
+    }
+    out.flush(std::cout);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lib/asm/assembler.hpp"
+
+int main(int argc, char* argv[]) {
+    std::string source_path, out_path, map_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) out_path = argv[++i];
+        else if (arg == "--map" && i + 1 < argc) map_path = argv[++i];
+        else if (source_path.empty()) source_path = arg;
+        else source_path.clear(), i = argc;
+    }
+    if (source_path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <source> [-o out.ch8] [--map out.map]\n";
+        return 1;
+    }
+    // Default outputs sit next to the source: game.s -> game.ch8 + game.map
+    auto stem = [](const std::string& path) {
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of('/');
+        return (dot == std::string::npos || (slash != std::string::npos && dot < slash)) ? path : path.substr(0, dot);
+    };
+    if (out_path.empty()) out_path = stem(source_path) + ".ch8";
+    if (map_path.empty()) map_path = stem(out_path) + ".map";
+
+    try {
+        Assembler assembler;
+        assembler.assemble_file(source_path);
+        assembler.finish();
+        std::vector<uint8_t> image = assembler.image();
+        std::ofstream out(out_path, std::ios::binary);
+        if (!out) throw std::runtime_error("Failed to open file " + out_path);
+        out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        if (!out) throw std::runtime_error("Failed to write file " + out_path);
+        assembler.source_map().save(map_path);
+        std::cerr << image.size() << " bytes written to " << out_path << ", source map " << map_path << "\n";
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
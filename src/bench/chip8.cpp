@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "analysis/analysis.hpp"
+#include "chip8/chip8.hpp"
+#include "disasm/disasm.hpp"
+#include "instructions/parser.hpp"
+#include "rom/rom.hpp"
+#include "ui/blend.hpp"
+#include "ui/scaler.hpp"
+
+// Google Benchmark suite for the hot paths. Write JSON for tracking across commits with
+//   chip8-bench [rom_dir] --benchmark_out=bench.json --benchmark_out_format=json
+// or the `bench` target, which does the same into the build directory.
+#define BENCH_ROM_BUDGET 20000 // Instructions per full-ROM run
+#define BENCH_SCALE 10         // Scale of the display conversion benchmarks
+#ifndef CHIP8_BENCH_ROMS
+#define CHIP8_BENCH_ROMS "tests" // Set by the build to the source tree's tests/
+#endif
+
+static std::vector<uint8_t> load_file(const std::string& path) {
+    MappedRom rom(path);
+    return std::vector<uint8_t>(rom.data(), rom.data() + rom.size());
+}
+
+// Every opcode through Chip8Parser::parse, as the reference engine decodes them
+static void BM_Parse(benchmark::State& state) {
+    uint16_t op = 0;
+    for (auto _ : state) {
+        std::unique_ptr<Inst> inst = Chip8Parser::parse(op++);
+        benchmark::DoNotOptimize(inst.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Parse);
+
+// The allocation-free classifier the switch engines use
+static void BM_Decode(benchmark::State& state) {
+    uint16_t op = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(decode(op++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Decode);
+
+// Machine with varied registers, I pointing at the font and the ROM area filled
+static Chip8 bench_machine() {
+    std::vector<uint8_t> image(MEM_SIZE - MEM_START);
+    for (size_t i = 0; i < image.size(); i++) image[i] = static_cast<uint8_t>(i * 37 + 11);
+    Chip8 chip8;
+    chip8.loadRom(image.data(), image.size());
+    for (uint8_t x = 0; x < N_REG; x++) SetConstInst(0x6000 | x << 8 | (x * 29 + 3)).execute(chip8, 0);
+    SetIndexInst(0xA000 | FONT_START).execute(chip8, 0);
+    return chip8;
+}
+
+// One instruction class executed over and over on the same machine
+template <typename T>
+static void BM_Execute(benchmark::State& state) {
+    Chip8 chip8 = bench_machine();
+    T inst(static_cast<inst_t>(state.range(0)));
+    for (auto _ : state) {
+        inst.execute(chip8, 0x0010);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Execute, ClearScreen)->Arg(0x00E0);
+BENCHMARK_TEMPLATE(BM_Execute, JumpInst)->Arg(0x1200);
+BENCHMARK_TEMPLATE(BM_Execute, SkipConstEqInst)->Arg(0x3320);
+BENCHMARK_TEMPLATE(BM_Execute, SkipConstNeqInst)->Arg(0x4320);
+BENCHMARK_TEMPLATE(BM_Execute, SkipRegEqInst)->Arg(0x5120);
+BENCHMARK_TEMPLATE(BM_Execute, SkipRegNeqInst)->Arg(0x9120);
+BENCHMARK_TEMPLATE(BM_Execute, SetConstInst)->Arg(0x6342);
+BENCHMARK_TEMPLATE(BM_Execute, AddConstInst)->Arg(0x7301);
+BENCHMARK_TEMPLATE(BM_Execute, LoadReg)->Arg(0x8120);
+BENCHMARK_TEMPLATE(BM_Execute, OrReg)->Arg(0x8121);
+BENCHMARK_TEMPLATE(BM_Execute, AndReg)->Arg(0x8122);
+BENCHMARK_TEMPLATE(BM_Execute, XorReg)->Arg(0x8123);
+BENCHMARK_TEMPLATE(BM_Execute, AddReg)->Arg(0x8124);
+BENCHMARK_TEMPLATE(BM_Execute, SubXY)->Arg(0x8125);
+BENCHMARK_TEMPLATE(BM_Execute, ShiftRightInst)->Arg(0x8126);
+BENCHMARK_TEMPLATE(BM_Execute, SubYX)->Arg(0x8127);
+BENCHMARK_TEMPLATE(BM_Execute, ShiftLeftInst)->Arg(0x812E);
+BENCHMARK_TEMPLATE(BM_Execute, SetIndexInst)->Arg(0xA300);
+BENCHMARK_TEMPLATE(BM_Execute, JumpOffsetInst)->Arg(0xB300);
+BENCHMARK_TEMPLATE(BM_Execute, RandInst)->Arg(0xC30F);
+BENCHMARK_TEMPLATE(BM_Execute, SkipIfKPInst)->Arg(0xE49E);
+BENCHMARK_TEMPLATE(BM_Execute, SkipIfNotKPInst)->Arg(0xE4A1);
+BENCHMARK_TEMPLATE(BM_Execute, TimerSetVXInst)->Arg(0xF307);
+BENCHMARK_TEMPLATE(BM_Execute, TimerSetDelayInst)->Arg(0xF315);
+BENCHMARK_TEMPLATE(BM_Execute, TimerSetSoundInst)->Arg(0xF318);
+BENCHMARK_TEMPLATE(BM_Execute, AddIRegInst)->Arg(0xF31E);
+BENCHMARK_TEMPLATE(BM_Execute, GetKeyInst)->Arg(0xF30A);
+BENCHMARK_TEMPLATE(BM_Execute, FontCharInst)->Arg(0xF329);
+BENCHMARK_TEMPLATE(BM_Execute, BinCodedDecConvInst)->Arg(0xF333);
+BENCHMARK_TEMPLATE(BM_Execute, StoreMemInst)->Arg(0xFF55);
+BENCHMARK_TEMPLATE(BM_Execute, LoadMemInst)->Arg(0xFF65);
+BENCHMARK_TEMPLATE(BM_Execute, AudioPatternInst)->Arg(0xF002);
+BENCHMARK_TEMPLATE(BM_Execute, PitchInst)->Arg(0xF33A);
+// Sprite drawing: aligned and straddling a byte boundary (V1 = 0x20, V2 = 0x3d), 1 and 15 rows
+BENCHMARK_TEMPLATE(BM_Execute, DisplayInst)->Arg(0xD101)->Arg(0xD10F)->Arg(0xD201)->Arg(0xD20F);
+
+// CALL and RET only make sense in pairs, or the stack overflows
+static void BM_CallReturn(benchmark::State& state) {
+    Chip8 chip8 = bench_machine();
+    SubroutInst call(0x2300);
+    ReturnInst ret(0x00EE);
+    for (auto _ : state) {
+        call.execute(chip8, 0);
+        ret.execute(chip8, 0);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_CallReturn);
+
+// What search dedup pays per state: the incremental hash against rehashing every byte
+static void BM_StateHash(benchmark::State& state) {
+    Chip8 chip8 = bench_machine();
+    const bool full = state.range(0);
+    for (auto _ : state) benchmark::DoNotOptimize(full ? chip8.full_state_hash() : chip8.state_hash());
+}
+BENCHMARK(BM_StateHash)->Arg(0)->Arg(1)->ArgName("full");
+
+// Restarting a full-size ROM: reset() from the loaded image, or loadRom from memory
+static void BM_Reset(benchmark::State& state) {
+    std::vector<uint8_t> image(MEM_SIZE - MEM_START);
+    for (size_t i = 0; i < image.size(); i++) image[i] = static_cast<uint8_t>(i * 37 + 11);
+    Chip8 chip8;
+    chip8.loadRom(image.data(), image.size());
+    const bool load = state.range(0);
+    for (auto _ : state) {
+        if (load) chip8.loadRom(image.data(), image.size());
+        else chip8.reset();
+        benchmark::DoNotOptimize(chip8.ram());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Reset)->Arg(0)->Arg(1)->ArgName("load");
+
+// A ROM restarted and run for BENCH_ROM_BUDGET instructions on one engine
+static void BM_Rom(benchmark::State& state, std::vector<uint8_t> image, Engine engine) {
+    Chip8 chip8;
+    chip8.set_engine(engine);
+    chip8.set_budget(BENCH_ROM_BUDGET, 0);
+    chip8.loadRom(image.data(), image.size());
+    size_t executed = 0;
+    for (auto _ : state) {
+        chip8.reset();
+        while (!chip8.finished()) chip8.step(0);
+        executed += chip8.ticks(); // Less than the budget for ROMs that halt on a self jump
+        benchmark::DoNotOptimize(chip8.display_rows());
+    }
+    state.SetItemsProcessed(executed);
+}
+
+// A call chain through the whole program area, 0x200-0xFFF: each 8-byte function sets V0,
+// skips on it, calls the next one and returns. Large enough to exercise every disassembler pass.
+static std::vector<uint8_t> full_program() {
+    std::vector<uint8_t> image;
+    for (uint16_t addr = MEM_START; addr + 8 <= MEM_SIZE; addr += 8) {
+        uint16_t next = addr + 8 < MEM_SIZE ? addr + 8 : MEM_START;
+        uint8_t words[8] = {0x60, static_cast<uint8_t>(addr), 0x30, 0x00,
+                            static_cast<uint8_t>(0x20 | next >> 8), static_cast<uint8_t>(next), 0x00, 0xEE};
+        image.insert(image.end(), words, words + 8);
+    }
+    return image;
+}
+
+// Disassembly and listing of an image, into a reused buffer and a discarding stream
+static void BM_Disassemble(benchmark::State& state, std::vector<uint8_t> image) {
+    TextBuffer buf;
+    std::ostringstream out;
+    for (auto _ : state) {
+        Disassembly disassembly(image.data(), image.size());
+        disassembly.write_listing(buf, out);
+        out.str("");
+    }
+    state.SetBytesProcessed(state.iterations() * image.size());
+}
+
+// What UI::display does per frame apart from the SDL texture lock: compose the blended
+// rows and scale them into a texture. A small loop of sprite draws keeps the frames changing.
+static void BM_Display(benchmark::State& state, Filter filter, Blend blend) {
+    const uint8_t program[] = {0xD1, 0x2F, 0x71, 0x03, 0x12, 0x00}; // DRW V1, V2, 15; ADDV V1, 3; JP 0x200
+    Chip8 chip8 = bench_machine();
+    chip8.loadRom(program, sizeof(program));
+    FrameBlender blender;
+    blender.mode = blend;
+    Scaler scaler(BENCH_SCALE, filter);
+    std::vector<uint32_t> texture(static_cast<size_t>(scaler.width()) * scaler.height());
+    int pitch = scaler.width() * sizeof(uint32_t);
+    for (auto _ : state) {
+        state.PauseTiming();
+        chip8.run_frame(0);
+        blender.capture(chip8);
+        state.ResumeTiming();
+        const uint64_t* ghost = nullptr;
+        const uint64_t* rows = blender.compose(chip8, ghost);
+        scaler.render(rows, texture.data(), pitch, ghost);
+        benchmark::DoNotOptimize(texture.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void register_benchmarks(const std::string& rom_dir) {
+    std::vector<std::filesystem::path> roms;
+    for (const auto& entry : std::filesystem::directory_iterator(rom_dir)) {
+        if (entry.path().extension() == ".ch8") roms.push_back(entry.path());
+    }
+    std::sort(roms.begin(), roms.end());
+    for (const auto& path : roms) {
+        std::vector<uint8_t> image = load_file(path.string());
+        std::string name = path.filename().string();
+        bool safe = analyze_program(image.data(), image.size()).predecode_safe();
+        for (Engine engine : {Engine::Reference, Engine::Switch, Engine::Predecoded}) {
+            if (engine == Engine::Predecoded && !safe) continue;
+            benchmark::RegisterBenchmark(("BM_Rom/" + name + "/" + engine_name(engine)).c_str(), BM_Rom, image, engine);
+        }
+        benchmark::RegisterBenchmark(("BM_Disassemble/" + name).c_str(), BM_Disassemble, image);
+    }
+    benchmark::RegisterBenchmark("BM_Disassemble/full-program", BM_Disassemble, full_program());
+
+    for (Filter filter : {Filter::Nearest, Filter::Scanline, Filter::PixelGrid, Filter::Phosphor}) {
+        for (Blend blend : {Blend::Off, Blend::Decay}) {
+            std::string name = std::string("BM_Display/") + filter_name(filter) + "/" + blend_name(blend);
+            benchmark::RegisterBenchmark(name.c_str(), BM_Display, filter, blend);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    benchmark::Initialize(&argc, argv);
+    std::string rom_dir = CHIP8_BENCH_ROMS;
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-')) {
+        std::cerr << "Usage: " << argv[0] << " [rom_dir] [--benchmark_* options]\n";
+        return 1;
+    }
+    if (argc == 2) rom_dir = argv[1];
+    try {
+        register_benchmarks(rom_dir);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "ui/scaler.hpp"
+
+// Times Scaler::render for every filter at a given scale (default 10x)
+int main(int argc, char* argv[]) {
+    int scale = argc > 1 ? std::atoi(argv[1]) : 10;
+    const int n_frames = 2000;
+
+    uint64_t rows[DISPLAY_HEIGHT];
+    srand(1);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        rows[y] = (static_cast<uint64_t>(rand()) << 32) ^ static_cast<uint64_t>(rand());
+    }
+
+    for (Filter filter : {Filter::Nearest, Filter::Scanline, Filter::PixelGrid, Filter::Phosphor}) {
+        Scaler scaler(scale, filter);
+        std::vector<uint32_t> texture(static_cast<size_t>(scaler.width()) * scaler.height());
+        int pitch = scaler.width() * sizeof(uint32_t);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < n_frames; i++) {
+            rows[i % DISPLAY_HEIGHT] ^= 1ull << (i % DISPLAY_WIDTH); // Keep the input changing
+            scaler.render(rows, texture.data(), pitch);
+        }
+        auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+        std::cout << filter_name(filter) << " " << scale << "x: "
+                  << elapsed.count() / n_frames << " us/frame\n";
+    }
+}
@@ -1,12 +1,55 @@
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lib/disasm/disasm.hpp"
 #include "lib/instructions/parser.hpp"
+#include "lib/rom/rom.hpp"
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename>\n";
+    bool flat = false;
+    std::string dot_path;
+    std::vector<const char*> filenames;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--flat") flat = true;
+        else if (arg == "--dot" && i + 1 < argc) dot_path = argv[++i];
+        else filenames.push_back(argv[i]);
+    }
+    if (filenames.empty() || (!dot_path.empty() && filenames.size() != 1)) {
+        std::cerr << "Usage: " << argv[0] << " [--flat] [--dot cfg.dot] <filename>\n"
+                  << "       " << argv[0] << " [--flat] <filename>...\n";
         return 1;
     }
-    const char* filename = argv[1];
-    Chip8Parser decompiler(filename);
-    std::cout << decompiler << "\n";
-}
\ No newline at end of file
+
+    // Many files per invocation share one output buffer; nothing goes through stdio sync
+    std::ios::sync_with_stdio(false);
+    TextBuffer buf;
+    int failures = 0;
+    for (const char* filename : filenames) {
+        try {
+            if (flat) {
+                // Every word from 0x200 decoded as an instruction
+                Chip8Parser decompiler(filename);
+                decompiler.write(buf, std::cout);
+                std::cout << "\n";
+                continue;
+            }
+            MappedRom rom(filename);
+            Disassembly disasm(rom.data(), rom.size());
+            buf.put("=== ").put(filename).put(" ===\n");
+            disasm.write_listing(buf, std::cout);
+            std::cout << "=== END ===\n";
+            if (!dot_path.empty()) {
+                std::ofstream dot(dot_path);
+                if (!dot) throw std::runtime_error("Failed to open file " + dot_path);
+                disasm.write_dot(dot, filename);
+            }
+        } catch (const std::runtime_error& e) {
+            std::cerr << filename << ": " << e.what() << "\n";
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "lib/analysis/analysis.hpp"
+#include "lib/cache/cache.hpp"
+#include "lib/chip8/chip8.hpp"
+#include "lib/chip8/input.hpp"
+#include "lib/capture/capture.hpp"
+#include "lib/debug/console.hpp"
+#include "lib/debug/gdb_stub.hpp"
+#include "lib/rom/rom.hpp"
+#include "lib/utils/format.hpp"
+#include "lib/utils/trace.hpp"
+
+static int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " <rom_file> [--frames N] [--instructions N] [--keys script] [--capture out.y4m|out.gif] [--capture-scale N] [--timing fixed|vip] [--engine auto|reference|switch|predecoded] [--debug commands|-] [--gdb port|socket] [--trace out.json] [--cache dir]\n";
+    return 1;
+}
+
+// Runs a ROM without a window, as fast as the host allows
+int main(int argc, char* argv[]) {
+    if (argc < 2 || !argv[1]) return usage(argv[0]);
+    const char* rom_path = argv[1];
+    size_t n_frames = 600;
+    size_t max_instructions = 0;
+    std::string capture_path;
+    InputScript input;
+    std::string keys;
+    int capture_scale = 4;
+    std::string debug_path;
+    std::string gdb_address;
+    std::string trace_path;
+    std::string cache_root;
+    Timing timing = Timing::Fixed;
+    Engine engine = Engine::Reference;
+    bool auto_engine = true; // fastest_safe_engine for the ROM
+    uint16_t gdb_port = 0;
+    for (int i = 2; i < argc; i += 2) {
+        std::string opt = argv[i];
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << opt << "\n";
+            return usage(argv[0]);
+        }
+        std::string value = argv[i + 1];
+        try {
+            if (opt == "--frames") {
+                n_frames = parse_count(value);
+            } else if (opt == "--instructions") {
+                max_instructions = parse_count(value);
+            } else if (opt == "--keys") {
+                input = InputScript(value);
+                keys = value;
+            } else if (opt == "--capture") {
+                capture_path = value;
+            } else if (opt == "--capture-scale") {
+                capture_scale = static_cast<int>(parse_count(value));
+            } else if (opt == "--timing") {
+                if (!parse_timing(value, timing)) {
+                    std::cerr << "Unknown timing: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--engine") {
+                auto_engine = value == "auto";
+                if (!auto_engine && !parse_engine(value, engine)) {
+                    std::cerr << "Unknown engine: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--debug") {
+                debug_path = value;
+            } else if (opt == "--gdb") {
+                gdb_address = value;
+                if (value.find_first_not_of("0123456789") == std::string::npos) {
+                    size_t port = parse_count(value);
+                    if (port > UINT16_MAX) throw std::out_of_range(value);
+                    gdb_port = static_cast<uint16_t>(port);
+                }
+            } else if (opt == "--trace") {
+                if (!TRACE_ENABLED) {
+                    std::cerr << "Tracing is not built in, configure with -DCHIP8_TRACE=ON\n";
+                    return 1;
+                }
+                trace_path = value;
+            } else if (opt == "--cache") {
+                cache_root = value;
+            } else {
+                std::cerr << "Unknown option: " << opt << "\n";
+                return usage(argv[0]);
+            }
+        } catch (const std::logic_error&) { // std::invalid_argument and std::out_of_range
+            std::cerr << "Bad value for " << opt << ": " << value << "\n";
+            return usage(argv[0]);
+        }
+    }
+
+    TRACE_THREAD("main");
+    Chip8 chip8;
+    chip8.set_timing(timing);
+    if (!chip8.loadRom(rom_path)) {
+        std::cerr << "Failed to load ROM: " << rom_path << "\n";
+        return 1;
+    }
+    chip8.set_engine(auto_engine ? fastest_safe_engine(chip8) : engine);
+
+    // Plain runs are a pure function of the ROM, keys, budget and emulator build: reuse an
+    // earlier result when there is one. Runs that record or debug always execute.
+    std::unique_ptr<ResultCache> cache;
+    RunKey key{};
+    if (!cache_root.empty() && capture_path.empty() && debug_path.empty() && gdb_address.empty() && trace_path.empty()) {
+        try {
+            cache = std::make_unique<ResultCache>(cache_root);
+            MappedRom rom(rom_path);
+            key = run_key(rom.data(), std::min<size_t>(rom.size(), MEM_SIZE - MEM_START), keys, n_frames,
+                          max_instructions, timing, chip8.get_engine());
+            RunResult cached;
+            if (cache->lookup(key, cached)) {
+                std::cout << "display hash: " << hex(cached.display_hash, 16) << "\n";
+                std::cout << "halt: " << halt_name(static_cast<Halt>(cached.halt)) << "\n";
+                if (cached.fault) {
+                    std::cout << "fault: " << fault_name(static_cast<Fault>(cached.fault)) << " at " << hex(cached.fault_pc, 3)
+                              << " (" << hex(cached.fault_opcode, 4) << ")\n";
+                }
+                std::cerr << "Cached result from " << cache->directory() << "\n";
+                return 0;
+            }
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << ", running without the cache\n";
+            cache.reset();
+        }
+    }
+
+    std::unique_ptr<Capture> capture;
+    if (!capture_path.empty()) {
+        CaptureFormat format;
+        if (!capture_format_for(capture_path, format)) {
+            std::cerr << "Unknown capture format: " << capture_path << "\n";
+            return 1;
+        }
+        capture = std::make_unique<Capture>(capture_path, format, capture_scale, chip8.frames_per_second());
+    }
+
+    // Remote debugging replaces the frame loop: the client decides what runs
+    if (!gdb_address.empty()) {
+        try {
+            bool is_port = gdb_address.find_first_not_of("0123456789") == std::string::npos;
+            std::unique_ptr<GdbStub> stub = is_port
+                ? std::make_unique<GdbStub>(chip8, gdb_port, input.keys_at(0))
+                : std::make_unique<GdbStub>(chip8, gdb_address, input.keys_at(0));
+            std::cerr << "Waiting for gdb on " << (is_port ? "127.0.0.1:" + std::to_string(stub->port()) : gdb_address) << "\n";
+            stub->serve();
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        std::cout << "display hash: " << hex(chip8.display_hash(), 16) << "\n";
+        if (chip8.fault() != Fault::None) std::cout << "fault: " << chip8.fault_message() << "\n";
+        return 0;
+    }
+
+    // Debug console on stdin or a command file: opened before the first instruction and
+    // at every breakpoint or watchpoint. Leaving it with "quit" or end of input stops the run.
+    Debugger debugger;
+    DebugConsole console(debugger, std::cout);
+    std::ifstream debug_file;
+    std::istream* commands = nullptr;
+    if (!debug_path.empty()) {
+        if (debug_path != "-") {
+            debug_file.open(debug_path);
+            if (!debug_file) {
+                std::cerr << "Failed to open file " << debug_path << "\n";
+                return 1;
+            }
+        }
+        commands = debug_path == "-" ? &std::cin : &debug_file;
+    }
+    bool running = !commands || console.run(*commands, chip8, input.keys_at(0));
+
+    // The machine stops itself on a self jump, a fault or the budget. A capture keeps
+    // showing the last picture for the remaining frames.
+    chip8.set_budget(max_instructions, n_frames);
+    for (size_t frame = 0; running && frame < n_frames && (capture || !chip8.finished()); frame++) {
+        if (!commands) {
+            chip8.run_frame(input.keys_at(frame));
+        } else if (!chip8.finished()) {
+            // Frames end on a cycle count under VIP timing, so go up to the boundary one step at a time
+            for (size_t end = chip8.frame_count() + 1; running && chip8.frame_count() < end && !chip8.finished();) {
+                Stop stop = debugger.run(chip8, 1, input.keys_at(frame));
+                if (stop.reason == StopReason::Steps || stop.reason == StopReason::Finished) continue;
+                console.report(stop, chip8);
+                running = console.run(*commands, chip8, input.keys_at(frame));
+            }
+        }
+        if (capture) capture->push(chip8.display_rows(), true);
+    }
+
+    std::cout << "display hash: " << hex(chip8.display_hash(), 16) << "\n";
+    std::cout << "halt: " << halt_name(chip8.halt()) << "\n";
+    if (chip8.fault() != Fault::None) std::cout << "fault: " << chip8.fault_message() << "\n";
+    if (cache && !cache->store(key, run_result(chip8))) std::cerr << "Failed to write to " << cache->directory() << "\n";
+    if (!trace_path.empty() && !trace_write(trace_path)) std::cerr << "Failed to write trace " << trace_path << "\n";
+    if (capture) std::cerr << "Captured " << capture->frames() << " frames to " << capture_path << "\n";
+    return 0;
+}
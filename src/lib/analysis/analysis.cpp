@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <map>
+#include "analysis.hpp"
+#include "../disasm/disasm.hpp"
+#include "../instructions/decode.hpp"
+#include "../rom/rom.hpp"
+
+namespace {
+
+// Values I may hold, lo <= hi <= 0xFFFF
+struct Range {
+    uint32_t lo, hi;
+    bool operator==(const Range& o) const { return lo == o.lo && hi == o.hi; }
+    bool operator!=(const Range& o) const { return !(*this == o); }
+};
+
+const Range ANY_I = {0, 0xFFFF};
+
+Range join(Range a, Range b) { return {std::min(a.lo, b.lo), std::max(a.hi, b.hi)}; }
+
+// I is 16 bits wide; a range that may wrap is given up on
+Range offset(Range r, uint32_t lo, uint32_t hi) {
+    if (r.hi + hi > 0xFFFF) return ANY_I;
+    return {r.lo + lo, r.hi + hi};
+}
+
+uint8_t quirk_of(OpKind kind) {
+    switch (kind) {
+    case OpKind::Or:
+    case OpKind::And:
+    case OpKind::Xor: return QUIRK_VF_RESET;
+    case OpKind::Str:
+    case OpKind::LdRm: return QUIRK_MEMORY;
+    case OpKind::Shr:
+    case OpKind::Shl: return QUIRK_SHIFT;
+    case OpKind::Jp0: return QUIRK_JUMP;
+    case OpKind::Drw: return QUIRK_DISPLAY;
+    default: return 0;
+    }
+}
+
+bool sets_index(OpKind kind) {
+    return kind == OpKind::Ldi || kind == OpKind::AddI || kind == OpKind::LdF || kind == OpKind::Str ||
+           kind == OpKind::LdRm;
+}
+
+class Analyzer {
+private:
+    const uint8_t* image;
+    uint32_t limit;
+    Disassembly dis;
+    const std::vector<BasicBlock>& blocks;
+    std::vector<int32_t> block_of; // Block index by start address, -1 elsewhere
+    std::map<uint32_t, std::vector<size_t>> bodies; // Function entry -> blocks reachable without a call
+    std::map<uint32_t, std::vector<uint32_t>> callees;
+    std::map<uint32_t, bool> changes_index; // The function, or one it calls, may change I
+    std::map<uint32_t, Range> write_ranges; // Fx33/Fx55 address -> bytes it may write
+
+    uint16_t word(uint32_t addr) const { return (image[addr - MEM_START] << 8) | image[addr - MEM_START + 1]; }
+
+    // Past the end of the image the machine keeps running whatever is in memory, which a
+    // write may have put there, so only decoded code inside the image is known
+    bool known_target(uint32_t addr) const { return addr < limit && dis.is_code(addr); }
+
+    void collect_functions();
+    int depth(uint32_t function, std::map<uint32_t, int>& memo);
+    void track_index();
+
+public:
+    Analyzer(const uint8_t* data, size_t size)
+        : image(data), limit(MEM_START + static_cast<uint32_t>(size)), dis(data, size, MEM_START),
+          blocks(dis.blocks()), block_of(DISASM_SPACE, -1) {
+        for (size_t i = 0; i < blocks.size(); i++) block_of[blocks[i].start] = static_cast<int32_t>(i);
+    }
+
+    ProgramAnalysis run();
+};
+
+void Analyzer::collect_functions() {
+    std::vector<bool> seen(blocks.size());
+    for (uint32_t entry : dis.functions()) {
+        std::vector<size_t>& body = bodies[entry];
+        std::vector<uint32_t>& calls = callees[entry];
+        bool sets = false;
+        std::fill(seen.begin(), seen.end(), false);
+        std::vector<size_t> work;
+        if (block_of[entry] >= 0) work.push_back(block_of[entry]);
+        while (!work.empty()) {
+            size_t b = work.back();
+            work.pop_back();
+            if (seen[b]) continue;
+            seen[b] = true;
+            body.push_back(b);
+            for (uint32_t a = blocks[b].start; a < blocks[b].end; a += 2) sets |= sets_index(decode(word(a)));
+            if (blocks[b].exit == Flow::Call && block_of[blocks[b].call] >= 0) calls.push_back(blocks[b].call);
+            for (uint32_t s : blocks[b].successors) {
+                if (block_of[s] >= 0) work.push_back(block_of[s]);
+            }
+        }
+        changes_index[entry] = sets;
+    }
+    // Through calls, until nothing changes
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto& [entry, calls] : callees) {
+            if (changes_index[entry]) continue;
+            for (uint32_t c : calls) {
+                if (changes_index[c]) {
+                    changes_index[entry] = changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Return addresses pushed below `function` at its deepest, ANALYSIS_UNBOUNDED on recursion
+int Analyzer::depth(uint32_t function, std::map<uint32_t, int>& memo) {
+    auto it = memo.find(function);
+    if (it != memo.end()) return it->second == -2 ? ANALYSIS_UNBOUNDED : it->second;
+    memo[function] = -2; // In progress, reaching it again means a call cycle
+    int deepest = 0;
+    for (uint32_t c : callees[function]) {
+        int d = depth(c, memo);
+        if (d == ANALYSIS_UNBOUNDED) {
+            deepest = ANALYSIS_UNBOUNDED;
+            break;
+        }
+        deepest = std::max(deepest, d + 1);
+    }
+    memo[function] = deepest;
+    return deepest;
+}
+
+// Forward dataflow over the blocks with the range of I as state. Calls pass the range to
+// the callee and, if the callee may change I, continue with any value.
+void Analyzer::track_index() {
+    std::vector<Range> entry(blocks.size());
+    std::vector<bool> reached(blocks.size());
+    std::vector<uint8_t> visits(blocks.size());
+    std::vector<size_t> work;
+    auto propagate = [&](uint32_t addr, Range r) {
+        if (addr >= DISASM_SPACE || block_of[addr] < 0) return;
+        size_t b = block_of[addr];
+        if (reached[b]) {
+            Range joined = join(entry[b], r);
+            if (joined == entry[b]) return;
+            r = ++visits[b] > ANALYSIS_WIDEN_AFTER ? ANY_I : joined;
+        }
+        reached[b] = true;
+        entry[b] = r;
+        work.push_back(b);
+    };
+    auto record = [&](uint32_t at, Range r) {
+        auto it = write_ranges.find(at);
+        write_ranges[at] = it == write_ranges.end() ? r : join(it->second, r);
+    };
+
+    propagate(MEM_START, {0, 0});
+    while (!work.empty()) {
+        const BasicBlock& block = blocks[work.back()];
+        Range r = entry[work.back()];
+        work.pop_back();
+        for (uint32_t a = block.start; a < block.end; a += 2) {
+            DecodedInst inst(word(a));
+            switch (inst.kind) {
+            case OpKind::Ldi: r = {inst.nnn(), inst.nnn()}; break;
+            case OpKind::AddI: r = offset(r, 0, 0xFF); break;
+            case OpKind::LdF: r = {FONT_START, FONT_START + 15 * 5}; break;
+            case OpKind::Bcd: record(a, offset(r, 0, 2)); break;
+            case OpKind::Str:
+                record(a, offset(r, 0, inst.x()));
+                r = offset(r, inst.x() + 1, inst.x() + 1);
+                break;
+            case OpKind::LdRm: r = offset(r, inst.x() + 1, inst.x() + 1); break;
+            case OpKind::Call:
+                propagate(inst.nnn(), r);
+                if (changes_index[inst.nnn()]) r = ANY_I;
+                break;
+            default: break;
+            }
+        }
+        for (uint32_t s : block.successors) propagate(s, r);
+    }
+}
+
+ProgramAnalysis Analyzer::run() {
+    ProgramAnalysis result;
+    result.image_bytes = limit - MEM_START;
+    result.code_bytes = dis.code_bytes();
+    result.instructions = dis.instructions();
+    result.functions = dis.functions().size();
+    result.blocks = blocks.size();
+    if (blocks.empty()) return result;
+
+    collect_functions();
+    std::map<uint32_t, int> memo;
+    result.max_stack_depth = depth(MEM_START, memo);
+    track_index();
+
+    for (const BasicBlock& block : blocks) {
+        for (uint32_t a = block.start; a < block.end; a += 2) result.quirks |= quirk_of(decode(word(a)));
+        const uint32_t last = block.end - 2;
+        const uint32_t nnn = word(last) & 0x0FFF;
+        switch (block.exit) {
+        case Flow::Next: result.complete &= known_target(block.end); break;
+        case Flow::Call: result.complete &= known_target(nnn) && known_target(block.end); break;
+        case Flow::Skip: result.complete &= known_target(block.end) && known_target(block.end + 2); break;
+        case Flow::Jump:
+        case Flow::Halt: result.complete &= known_target(nnn); break;
+        case Flow::Return: break;
+        case Flow::Computed:
+        case Flow::Invalid: result.complete = false; break;
+        }
+    }
+
+    for (const auto& [at, r] : write_ranges) {
+        MemoryWrite w{at, r.lo, r.hi, false};
+        if (w.last > MEM_MASK) { // Wraps around the address space
+            w.first = 0;
+            w.last = MEM_MASK;
+        }
+        for (uint32_t addr = w.first; addr <= w.last && !w.overlaps_code; addr++) w.overlaps_code = dis.covers(addr);
+        result.self_modifying |= w.overlaps_code;
+        result.writes.push_back(w);
+    }
+    return result;
+}
+
+} // namespace
+
+ProgramAnalysis analyze_program(const uint8_t* data, size_t size) {
+    size = std::min<size_t>(size, MEM_SIZE - MEM_START);
+    return Analyzer(data, size).run();
+}
+
+Engine fastest_safe_engine(const ProgramAnalysis& analysis) {
+    return analysis.predecode_safe() ? Engine::Predecoded : Engine::Switch;
+}
+
+Engine fastest_safe_engine(const Chip8& chip8) {
+    return fastest_safe_engine(analyze_program(chip8.ram() + MEM_START, chip8.rom_size()));
+}
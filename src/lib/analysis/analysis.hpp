@@ -0,0 +1,51 @@
+#ifndef SRC_LIB_ANALYSIS_HPP
+#define SRC_LIB_ANALYSIS_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "../chip8/chip8.hpp"
+
+#define ANALYSIS_STACK_LIMIT 16 // Entries in Chip8::stack
+#define ANALYSIS_UNBOUNDED -1   // Stack depth when subroutines recurse
+#define ANALYSIS_WIDEN_AFTER 8  // Block revisits before a growing range of I is given up on
+
+// Bytes one Fx33 or Fx55 instruction may write, for every value I can have there
+struct MemoryWrite {
+    uint32_t at;    // Address of the instruction
+    uint32_t first; // Lowest address written
+    uint32_t last;  // Highest address written, inclusive
+    bool overlaps_code;
+};
+
+struct ProgramAnalysis {
+    size_t image_bytes = 0;
+    size_t code_bytes = 0; // Bytes of instructions reachable from the entry point
+    size_t instructions = 0;
+    size_t functions = 0;
+    size_t blocks = 0;
+    int max_stack_depth = 0; // Return addresses on the stack at the deepest call, or ANALYSIS_UNBOUNDED
+    std::vector<MemoryWrite> writes;
+    bool self_modifying = false; // Some write may land on reachable code
+    // Every instruction that can execute was found: no computed jumps (Bnnn), no invalid
+    // opcodes and no jumps or fall-through out of the image. Without this, writes are not proven harmless.
+    bool complete = true;
+    uint8_t quirks = 0; // Quirk bits (rom/rom.hpp) of reachable instructions
+
+    bool stack_safe() const { return max_stack_depth != ANALYSIS_UNBOUNDED && max_stack_depth <= ANALYSIS_STACK_LIMIT; }
+    // No instruction that executes is ever overwritten, so a decode cache never goes stale
+    bool predecode_safe() const { return complete && !self_modifying; }
+};
+
+// Static analysis of a ROM image loaded at MEM_START. Works from the recursive
+// disassembly and tracks the range of I through the control-flow graph, so the writes
+// of Fx33/Fx55 are bounded wherever I was set by Annn, Fx29 or a bounded Fx1E.
+ProgramAnalysis analyze_program(const uint8_t* data, size_t size);
+
+// Fastest engine that gives the same results as Engine::Reference for this program
+Engine fastest_safe_engine(const ProgramAnalysis& analysis);
+// The same for the ROM `chip8` has just loaded, for runners to pick their engine with
+Engine fastest_safe_engine(const Chip8& chip8);
+
+#endif
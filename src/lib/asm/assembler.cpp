@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <cctype>
+#include "assembler.hpp"
+#include "../instructions/decode.hpp"
+#include "../rom/rom.hpp"
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && isspace(static_cast<unsigned char>(s.back()))) s.remove_suffix(1);
+    return s;
+}
+
+// Splits off the first whitespace separated token
+static std::string_view next_token(std::string_view& s) {
+    s = trim(s);
+    size_t n = 0;
+    while (n < s.size() && !isspace(static_cast<unsigned char>(s[n]))) n++;
+    std::string_view token = s.substr(0, n);
+    s.remove_prefix(n);
+    return token;
+}
+
+static bool is_identifier(std::string_view s) {
+    if (s.empty() || !(isalpha(static_cast<unsigned char>(s[0])) || s[0] == '_' || s[0] == '.')) return false;
+    return std::all_of(s.begin(), s.end(), [](char c) {
+        return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+    });
+}
+
+static bool parse_hex(std::string_view s, uint32_t& out) {
+    if (s.empty() || s.size() > 8) return false;
+    out = 0;
+    for (char c : s) {
+        int d = isdigit(static_cast<unsigned char>(c)) ? c - '0'
+              : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+              : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (d < 0) return false;
+        out = out * 16 + d;
+    }
+    return true;
+}
+
+// Mnemonic to kind, keyed by the upper case names from types.hpp
+static const std::unordered_map<std::string_view, OpKind>& mnemonics() {
+    static const std::unordered_map<std::string_view, OpKind> table = [] {
+        std::unordered_map<std::string_view, OpKind> t;
+        for (size_t i = 0; i < static_cast<size_t>(OpKind::Count); i++) t.emplace(op_info[i].cmd, static_cast<OpKind>(i));
+        return t;
+    }();
+    return table;
+}
+
+Assembler::Assembler(uint32_t origin): origin(origin), pc(origin), end(origin), memory(ASM_SPACE) {}
+
+std::string Assembler::where() const {
+    return file_name + ":" + std::to_string(line_no);
+}
+
+void Assembler::error(const std::string& message) const {
+    throw AsmError(where() + ": " + message);
+}
+
+void Assembler::bind_labels() {
+    for (const std::string& name : pending_labels) {
+        if (!symbols.emplace(name, pc).second) error("label '" + name + "' defined twice");
+    }
+    pending_labels.clear();
+}
+
+void Assembler::put(uint8_t byte) {
+    if (pc < origin || pc >= ASM_SPACE) error("address out of range");
+    memory[pc++] = byte;
+    end = std::max(end, pc);
+}
+
+uint32_t Assembler::number(std::string_view token, uint32_t max) const {
+    uint32_t v = 0;
+    int32_t addend = 0;
+    std::string symbol;
+    if (!value(token, v, addend, symbol)) error("undefined symbol '" + symbol + "' in a constant");
+    if (v > max) error("value " + std::string(token) + " out of range");
+    return v;
+}
+
+// Number (0x.., 0b.. or decimal) or symbol[+-N]. Returns false for a symbol not defined yet, with
+// its name and offset set so the caller can record a fixup.
+bool Assembler::value(std::string_view token, uint32_t& out, int32_t& addend, std::string& symbol) const {
+    token = trim(token);
+    if (token.empty()) error("missing value");
+    bool negative = token[0] == '-';
+    if (negative) token.remove_prefix(1);
+    uint32_t v = 0;
+    if (token.size() > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X')) {
+        if (!parse_hex(token.substr(2), v)) error("bad number '" + std::string(token) + "'");
+    } else if (token.size() > 2 && token[0] == '0' && (token[1] == 'b' || token[1] == 'B')) {
+        for (char c : token.substr(2)) {
+            if (c != '0' && c != '1') error("bad number '" + std::string(token) + "'");
+            v = v * 2 + (c - '0');
+        }
+    } else if (isdigit(static_cast<unsigned char>(token[0]))) {
+        for (char c : token) {
+            if (!isdigit(static_cast<unsigned char>(c))) error("bad number '" + std::string(token) + "'");
+            v = v * 10 + (c - '0');
+        }
+    } else {
+        if (negative) error("bad value '-" + std::string(token) + "'");
+        size_t op = token.find_first_of("+-");
+        std::string_view name = trim(token.substr(0, op));
+        addend = 0;
+        if (op != std::string_view::npos) {
+            addend = static_cast<int32_t>(number(token.substr(op + 1), 0xFFFF));
+            if (token[op] == '-') addend = -addend;
+        }
+        if (!is_identifier(name)) error("bad value '" + std::string(token) + "'");
+        symbol.assign(name.data(), name.size());
+        auto it = symbols.find(symbol);
+        if (it == symbols.end()) return false;
+        out = static_cast<uint32_t>(static_cast<int32_t>(it->second) + addend);
+        return true;
+    }
+    out = negative ? static_cast<uint32_t>(0x100 - (v & 0xFF)) & 0xFF : v; // -N only makes sense as a byte
+    return true;
+}
+
+uint8_t Assembler::reg(std::string_view token) const {
+    token = trim(token);
+    uint32_t v;
+    if (token.size() != 2 || (token[0] != 'V' && token[0] != 'v') || !parse_hex(token.substr(1), v)) {
+        error("expected a register V0-VF, got '" + std::string(token) + "'");
+    }
+    return static_cast<uint8_t>(v);
+}
+
+void Assembler::assemble_file(const std::string& path) {
+    MappedRom source(path);
+    std::string_view text(reinterpret_cast<const char*>(source.data()), source.size());
+    assemble_source(text, path, path.substr(0, path.find_last_of('/') + 1)); // npos + 1 == 0
+}
+
+void Assembler::assemble_source(std::string_view text, const std::string& name, const std::string& base_dir) {
+    if (++depth > ASM_MAX_INCLUDE_DEPTH) error("includes nested too deeply");
+    // Save the including file's position; restored after this file is done
+    std::string saved_name = file_name, saved_dir = dir;
+    uint32_t saved_id = file_id, saved_line = line_no;
+    file_name = name;
+    dir = base_dir;
+    file_id = map.add_file(name);
+    line_no = 0;
+
+    while (!text.empty()) {
+        size_t nl = text.find('\n');
+        std::string_view line = text.substr(0, nl);
+        text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+        line_no++;
+        assemble_line(line);
+    }
+
+    file_name = saved_name;
+    dir = saved_dir;
+    file_id = saved_id;
+    line_no = saved_line;
+    depth--;
+}
+
+void Assembler::assemble_line(std::string_view line) {
+    line = trim(line.substr(0, line.find(';')));
+    if (line.empty() || line.compare(0, 3, "===") == 0) return;
+
+    // Listing address column
+    bool listing = false;
+    if (line.size() > 3 && line[0] == '0' && (line[1] == 'x' || line[1] == 'X')) {
+        std::string_view rest = line;
+        std::string_view column = next_token(rest);
+        uint32_t addr;
+        if (column.back() == ':' && parse_hex(column.substr(2, column.size() - 3), addr)) {
+            if (addr >= ASM_SPACE) error("address out of range");
+            pc = addr;
+            line = trim(rest);
+            listing = true;
+        }
+    }
+
+    std::string_view rest = line;
+    std::string_view token = next_token(rest);
+    while (!token.empty() && token.back() == ':') {
+        std::string_view name = token.substr(0, token.size() - 1);
+        if (!is_identifier(name)) error("bad label '" + std::string(name) + "'");
+        pending_labels.emplace_back(name);
+        token = next_token(rest);
+    }
+    if (token.empty()) return;
+    bind_labels();
+
+    // Opcode column after the address column
+    int expected = -1;
+    uint32_t op;
+    if (listing && token.size() == 4 && parse_hex(token, op)) {
+        expected = static_cast<int>(op);
+        token = next_token(rest);
+    }
+
+    char upper[16];
+    if (token.size() >= sizeof(upper)) error("unknown mnemonic '" + std::string(token) + "'");
+    for (size_t i = 0; i < token.size(); i++) upper[i] = static_cast<char>(toupper(static_cast<unsigned char>(token[i])));
+    std::string_view mnemonic(upper, token.size());
+    if (mnemonic == "DB" || mnemonic == "DW" || mnemonic == "ORG" || mnemonic == "INCLUDE") {
+        directive(mnemonic, trim(rest));
+    } else {
+        instruction(mnemonic, trim(rest), expected);
+    }
+}
+
+void Assembler::directive(std::string_view name, std::string_view operands) {
+    if (name == "ORG") {
+        pc = number(operands, ASM_SPACE - 1);
+        return;
+    }
+    if (name == "INCLUDE") {
+        if (operands.size() >= 2 && operands.front() == '"' && operands.back() == '"') {
+            operands = operands.substr(1, operands.size() - 2);
+        }
+        if (operands.empty()) error("INCLUDE needs a file name");
+        std::string path = operands[0] == '/' ? std::string(operands) : dir + std::string(operands);
+        MappedRom source(path);
+        std::string_view text(reinterpret_cast<const char*>(source.data()), source.size());
+        assemble_source(text, path, path.substr(0, path.find_last_of('/') + 1));
+        return;
+    }
+
+    uint32_t start = pc;
+    while (true) {
+        size_t comma = operands.find(',');
+        std::string_view item = trim(operands.substr(0, comma));
+        if (item.empty()) error(std::string(name) + " needs a value");
+        if (name == "DB") {
+            put(static_cast<uint8_t>(number(item, 0xFF)));
+        } else {
+            uint32_t v = 0;
+            int32_t addend = 0;
+            std::string symbol;
+            if (!value(item, v, addend, symbol)) fixups.push_back({pc, FixupKind::Word, symbol, addend, where()});
+            if (v > 0xFFFF) error("value out of range");
+            put(static_cast<uint8_t>(v >> 8));
+            put(static_cast<uint8_t>(v & 0xFF));
+        }
+        if (comma == std::string_view::npos) break;
+        operands.remove_prefix(comma + 1);
+    }
+    map.add(static_cast<uint16_t>(start), static_cast<uint16_t>(pc - start), file_id, line_no);
+}
+
+void Assembler::instruction(std::string_view mnemonic, std::string_view operands, int expected) {
+    auto it = mnemonics().find(mnemonic);
+    if (it == mnemonics().end()) error("unknown mnemonic '" + std::string(mnemonic) + "'");
+    const OpInfo& info = op_info[static_cast<size_t>(it->second)];
+
+    // Operand slots in the order the listing prints them
+    enum Slot { X, Y, N, NN, NNN, IDX, RAW, NONE };
+    Slot order[3] = {NONE, NONE, NONE};
+    switch (info.shape) {
+    case ArgShape::None: break;
+    case ArgShape::Addr: order[0] = NNN; break;
+    case ArgShape::RegByte: order[0] = X; order[1] = NN; break;
+    case ArgShape::RegReg: order[0] = X; order[1] = Y; break;
+    case ArgShape::Reg: order[0] = X; break;
+    case ArgShape::Sprite: order[0] = X; order[1] = Y; order[2] = N; break;
+    case ArgShape::IndexReg: order[0] = IDX; order[1] = X; break;
+    case ArgShape::Index: order[0] = IDX; break;
+    case ArgShape::Raw: order[0] = RAW; break;
+    }
+
+    uint32_t field[RAW + 1] = {};
+    bool given[RAW + 1] = {};
+    std::string symbol;
+    int32_t addend = 0;
+    bool pending = false;
+    size_t position = 0;
+    while (!operands.empty()) {
+        size_t comma = operands.find(',');
+        std::string_view item = trim(operands.substr(0, comma));
+        operands.remove_prefix(comma == std::string_view::npos ? operands.size() : comma + 1);
+        if (item.empty()) error("empty operand");
+
+        Slot slot;
+        size_t eq = item.find('=');
+        if (eq != std::string_view::npos) {
+            std::string_view key = trim(item.substr(0, eq));
+            item = trim(item.substr(eq + 1));
+            slot = key == "X" ? X : key == "Y" ? Y : key == "N" ? N : key == "NN" ? NN : key == "NNN" ? NNN : NONE;
+            if (slot == NONE || std::find(order, order + 3, slot) == order + 3) {
+                error("operand " + std::string(key) + " not used by " + std::string(info.cmd));
+            }
+        } else {
+            if (position >= 3 || order[position] == NONE) error("too many operands for " + std::string(info.cmd));
+            slot = order[position];
+        }
+        position++;
+        if (given[slot]) error("operand given twice");
+        given[slot] = true;
+
+        switch (slot) {
+        case X:
+        case Y: field[slot] = reg(item); break;
+        case N: field[slot] = number(item, 0xF); break;
+        case NN: field[slot] = number(item, 0xFF); break;
+        case RAW: field[slot] = number(item, 0xFFFF); break;
+        case IDX:
+            if (item != "I" && item != "i") error("expected I, got '" + std::string(item) + "'");
+            break;
+        case NNN:
+            if (!value(item, field[NNN], addend, symbol)) pending = true;
+            else if (field[NNN] > 0xFFF) error("address " + std::string(item) + " out of range");
+            break;
+        case NONE: break;
+        }
+    }
+
+    // Fixed low bytes (LD.DT, ST.DT, ST.ST) print NN; accept it only when it matches
+    bool fixed_nn = info.shape == ArgShape::RegByte && (info.base & 0xFF) != 0;
+    if (fixed_nn && given[NN] && field[NN] != (info.base & 0xFFu)) error("NN must be " + std::to_string(info.base & 0xFF));
+    for (Slot s : order) {
+        if (s == NONE || given[s] || (s == NN && fixed_nn)) continue;
+        error("missing operand for " + std::string(info.cmd));
+    }
+
+    uint32_t opcode = info.shape == ArgShape::Raw ? field[RAW]
+                    : info.base | (field[X] << 8) | (field[Y] << 4) | field[N] | (fixed_nn ? 0 : field[NN]) | field[NNN];
+    if (pending) fixups.push_back({pc, FixupKind::Addr12, symbol, addend, where()});
+    else if (expected >= 0 && static_cast<uint32_t>(expected) != opcode) error("opcode column does not match the instruction");
+    map.add(static_cast<uint16_t>(pc), 2, file_id, line_no);
+    put(static_cast<uint8_t>(opcode >> 8));
+    put(static_cast<uint8_t>(opcode & 0xFF));
+}
+
+void Assembler::finish() {
+    if (finished) return;
+    bind_labels();
+    for (const Fixup& f : fixups) {
+        auto it = symbols.find(f.symbol);
+        if (it == symbols.end()) throw AsmError(f.where + ": undefined symbol '" + f.symbol + "'");
+        int32_t v = static_cast<int32_t>(it->second) + f.addend;
+        if (f.kind == FixupKind::Addr12) {
+            if (v < 0 || v > 0xFFF) throw AsmError(f.where + ": address of '" + f.symbol + "' out of range");
+            memory[f.at] = static_cast<uint8_t>((memory[f.at] & 0xF0) | (v >> 8));
+            memory[f.at + 1] = static_cast<uint8_t>(v & 0xFF);
+        } else {
+            if (v < 0 || v > 0xFFFF) throw AsmError(f.where + ": value of '" + f.symbol + "' out of range");
+            memory[f.at] = static_cast<uint8_t>(v >> 8);
+            memory[f.at + 1] = static_cast<uint8_t>(v & 0xFF);
+        }
+    }
+    map.sort();
+    finished = true;
+}
+
+std::vector<uint8_t> Assembler::image() const {
+    return std::vector<uint8_t>(memory.begin() + origin, memory.begin() + end);
+}
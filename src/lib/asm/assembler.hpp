@@ -0,0 +1,89 @@
+#ifndef SRC_LIB_ASSEMBLER_HPP
+#define SRC_LIB_ASSEMBLER_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "source_map.hpp"
+
+#define ASM_SPACE 0x10000       // Addresses an ORG may reach, the XO-CHIP address space
+#define ASM_MAX_INCLUDE_DEPTH 16
+
+// Error in a source file, with "file:line: " in front of the message
+class AsmError: public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+// Single-pass assembler for the mnemonics in instructions/types.hpp.
+//
+// Syntax, one statement per line, ';' starts a comment:
+//   label:                      defines label at the address of the next statement
+//   LDV V1, 0x20                positional operands in the order the listing prints them
+//   LDV X=V1, NN=0x20           or named, exactly as decompile prints them
+//   JP loop                     NNN operands and DW values may be labels, label+N or label-N
+//   DB 0xff, 0x00 / DW 0x1234   data bytes / big-endian words
+//   ORG 0x300                   moves the current address
+//   INCLUDE "other.s"           relative to the including file
+// A leading "0x0200:" address column sets the address for that line, and a following
+// four-digit opcode column is checked against the encoding, so decompile listings
+// assemble back to the original image. Lines starting with "===" are listing banners.
+// Forward references are patched when finish() is called.
+class Assembler {
+private:
+    enum class FixupKind : uint8_t { Addr12, Word };
+    struct Fixup {
+        uint32_t at;
+        FixupKind kind;
+        std::string symbol;
+        int32_t addend;
+        std::string where; // "file:line" for errors
+    };
+
+    uint32_t origin;
+    uint32_t pc;
+    uint32_t end;
+    std::vector<uint8_t> memory;
+    std::unordered_map<std::string, uint32_t> symbols;
+    std::vector<Fixup> fixups;
+    std::vector<std::string> pending_labels; // Bound to the address of the next statement
+    SourceMap map;
+    bool finished = false;
+
+    // Position of the line being assembled
+    std::string file_name;
+    uint32_t file_id = 0;
+    uint32_t line_no = 0;
+    std::string dir;
+    int depth = 0;
+
+    [[noreturn]] void error(const std::string& message) const;
+    std::string where() const;
+    void assemble_line(std::string_view line);
+    void directive(std::string_view name, std::string_view operands);
+    void instruction(std::string_view mnemonic, std::string_view operands, int expected);
+    bool value(std::string_view token, uint32_t& out, int32_t& addend, std::string& symbol) const;
+    uint32_t number(std::string_view token, uint32_t max) const;
+    uint8_t reg(std::string_view token) const;
+    void put(uint8_t byte);
+    void bind_labels();
+
+public:
+    explicit Assembler(uint32_t origin = 0x200);
+
+    // Both throw AsmError on syntax errors and std::runtime_error on I/O errors
+    void assemble_file(const std::string& path);
+    void assemble_source(std::string_view text, const std::string& name, const std::string& base_dir = "");
+    // Patches forward references; throws AsmError for undefined symbols
+    void finish();
+
+    // Bytes from the origin to the highest address written
+    std::vector<uint8_t> image() const;
+    const SourceMap& source_map() const { return map; }
+    const std::unordered_map<std::string, uint32_t>& labels() const { return symbols; }
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "source_map.hpp"
+
+uint32_t SourceMap::add_file(const std::string& path) {
+    file_names.push_back(path);
+    return static_cast<uint32_t>(file_names.size() - 1);
+}
+
+void SourceMap::add(uint16_t addr, uint16_t size, uint32_t file, uint32_t line) {
+    lines.push_back({addr, size, file, line});
+}
+
+void SourceMap::sort() {
+    std::stable_sort(lines.begin(), lines.end(),
+        [](const SourceLine& a, const SourceLine& b) { return a.addr < b.addr; });
+    longest = 0;
+    for (const SourceLine& l : lines) longest = std::max<uint32_t>(longest, l.size);
+}
+
+const SourceLine* SourceMap::find(uint16_t addr) const {
+    // Last entry starting at or before addr; later lines win where ORG overlaps code
+    auto it = std::upper_bound(lines.begin(), lines.end(), addr,
+        [](uint16_t a, const SourceLine& l) { return a < l.addr; });
+    while (it != lines.begin()) {
+        --it;
+        if (addr < it->addr + it->size) return &*it;
+        if (it->addr + longest <= addr) break; // Nothing earlier can reach addr
+    }
+    return nullptr;
+}
+
+std::string SourceMap::describe(uint16_t addr) const {
+    const SourceLine* l = find(addr);
+    if (!l) return "";
+    return file_names[l->file] + ":" + std::to_string(l->line);
+}
+
+void SourceMap::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to open file " + path);
+    out << SOURCE_MAP_MAGIC << "\n";
+    for (const std::string& f : file_names) out << "file " << f << "\n";
+    for (const SourceLine& l : lines) out << l.addr << " " << l.size << " " << l.file << " " << l.line << "\n";
+    if (!out) throw std::runtime_error("Failed to write file " + path);
+}
+
+SourceMap SourceMap::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Failed to open file " + path);
+    std::string text;
+    if (!std::getline(in, text) || text != SOURCE_MAP_MAGIC) throw std::runtime_error("Not a source map: " + path);
+    SourceMap map;
+    while (std::getline(in, text)) {
+        if (text.compare(0, 5, "file ") == 0) {
+            map.add_file(text.substr(5));
+            continue;
+        }
+        std::istringstream fields(text);
+        uint32_t addr, size, file, line;
+        if (!(fields >> addr >> size >> file >> line) || file >= map.file_names.size() || addr > 0xFFFF) {
+            throw std::runtime_error("Malformed source map line: " + text);
+        }
+        map.add(static_cast<uint16_t>(addr), static_cast<uint16_t>(size), file, line);
+    }
+    map.sort();
+    return map;
+}
@@ -0,0 +1,44 @@
+#ifndef SRC_LIB_SOURCE_MAP_HPP
+#define SRC_LIB_SOURCE_MAP_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define SOURCE_MAP_MAGIC "chip8-map 1"
+
+// Source line that produced the bytes at [addr, addr + size)
+struct SourceLine {
+    uint16_t addr;
+    uint16_t size;
+    uint32_t file; // Index into SourceMap::files()
+    uint32_t line; // 1-based
+};
+
+// Address to source line table written by the assembler next to the binary. Text format:
+// a magic line, one "file <path>" line per source file, then "<addr> <size> <file> <line>".
+class SourceMap {
+private:
+    std::vector<std::string> file_names;
+    std::vector<SourceLine> lines; // Sorted by address once finalised
+    uint32_t longest = 0;          // Largest size, bounds the backwards search in find()
+
+public:
+    uint32_t add_file(const std::string& path);
+    void add(uint16_t addr, uint16_t size, uint32_t file, uint32_t line);
+    void sort();
+
+    const std::vector<std::string>& files() const { return file_names; }
+    const std::vector<SourceLine>& entries() const { return lines; }
+
+    // Line covering `addr`, or nullptr. Binary search; call sort() after adding entries.
+    const SourceLine* find(uint16_t addr) const;
+    // "file:line" for `addr`, or an empty string
+    std::string describe(uint16_t addr) const;
+
+    // Both throw std::runtime_error on I/O or format errors
+    void save(const std::string& path) const;
+    static SourceMap load(const std::string& path);
+};
+
+#endif
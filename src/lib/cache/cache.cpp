@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include "cache.hpp"
+#include "../utils/format.hpp"
+#include "../utils/hash.hpp"
+
+// Generated by src/lib/version.cmake; missing when a file is compiled outside the build
+#if __has_include("lib_version.hpp")
+#include "lib_version.hpp"
+#else
+#define CHIP8_LIB_VERSION ""
+#endif
+
+namespace {
+
+struct CacheRecord {
+    char magic[4];
+    uint32_t version;
+    RunKey key;
+    RunResult result;
+};
+
+static_assert(sizeof(CacheRecord) == 112, "CacheRecord must stay 112 bytes");
+
+}
+
+RunKey run_key(const uint8_t* rom, size_t size, const std::string& keys, size_t frames, size_t instructions,
+               Timing timing, Engine engine) {
+    RunKey key{};
+    key.rom_hash = hash_bytes(rom, size);
+    key.input_hash = hash_bytes(keys.data(), keys.size());
+    key.frames = frames;
+    key.instructions = instructions;
+    key.timing = static_cast<uint8_t>(timing);
+    key.engine = static_cast<uint8_t>(engine);
+    return key;
+}
+
+RunResult run_result(const Chip8& chip8) {
+    RunResult result{};
+    result.display_hash = chip8.display_hash();
+    result.state_hash = chip8.state_hash();
+    result.ticks = chip8.ticks();
+    result.frames = chip8.frame_count();
+    result.pc = chip8.program_counter();
+    result.I = chip8.index();
+    memcpy(result.V, chip8.registers(), N_REG);
+    result.sp = chip8.stack_pointer();
+    result.delay = chip8.delay_timer();
+    result.sound = chip8.sound_timer();
+    result.finished = chip8.finished();
+    result.fault = static_cast<uint8_t>(chip8.fault());
+    result.halt = static_cast<uint8_t>(chip8.halt());
+    result.fault_pc = chip8.fault_pc();
+    result.fault_opcode = chip8.fault_opcode();
+    return result;
+}
+
+const char* library_version() {
+    return CHIP8_LIB_VERSION;
+}
+
+ResultCache::ResultCache(const std::string& root) {
+    if (!*library_version()) throw std::runtime_error("Result cache needs a build with a library version");
+    dir = root + "/" + library_version();
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+    if (error) throw std::runtime_error("Failed to create directory " + dir);
+}
+
+std::string ResultCache::path(const RunKey& key) const {
+    return dir + "/" + hex(hash_bytes(&key, sizeof(key)), 16).substr(2);
+}
+
+bool ResultCache::lookup(const RunKey& key, RunResult& result) const {
+    std::ifstream in(path(key), std::ios::binary);
+    CacheRecord record;
+    if (!in.read(reinterpret_cast<char*>(&record), sizeof(record))) return false;
+    // The full key is stored, so a file name collision reads as a miss
+    if (memcmp(record.magic, RESULT_CACHE_MAGIC, 4) != 0 || record.version != RESULT_CACHE_VERSION ||
+        memcmp(&record.key, &key, sizeof(key)) != 0) {
+        return false;
+    }
+    result = record.result;
+    return true;
+}
+
+bool ResultCache::store(const RunKey& key, const RunResult& result) const {
+    CacheRecord record;
+    memcpy(record.magic, RESULT_CACHE_MAGIC, 4);
+    record.version = RESULT_CACHE_VERSION;
+    record.key = key;
+    record.result = result;
+    // Write next to the entry and rename, so concurrent runners never read half an entry
+    std::string out_path = path(key);
+    std::string tmp_path = out_path + ".tmp" + std::to_string(getpid()) + "-" +
+                           std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write(reinterpret_cast<const char*>(&record), sizeof(record))) return false;
+    }
+    if (std::rename(tmp_path.c_str(), out_path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
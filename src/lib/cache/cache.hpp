@@ -0,0 +1,74 @@
+#ifndef SRC_LIB_CACHE_HPP
+#define SRC_LIB_CACHE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "../chip8/chip8.hpp"
+
+#define RESULT_CACHE_MAGIC "C8RC"
+#define RESULT_CACHE_VERSION 3 // Bump when RunKey or RunResult change layout
+
+// Everything a headless run's outcome depends on besides the emulator itself. Fixed
+// little-endian records, zero filled so padding never changes a key.
+struct RunKey {
+    uint64_t rom_hash;   // hash_bytes of the image, as in the ROM index
+    uint64_t input_hash; // hash_bytes of the key script text
+    uint64_t frames;     // Frame budget
+    uint64_t instructions; // Instruction budget, 0 for none
+    uint8_t timing;
+    uint8_t engine;
+    uint8_t reserved[6];
+};
+
+// Machine state at the end of a run
+struct RunResult {
+    uint64_t display_hash;
+    uint64_t state_hash;
+    uint64_t ticks;
+    uint64_t frames;
+    uint16_t pc;
+    uint16_t I;
+    uint8_t V[N_REG];
+    uint8_t sp;
+    uint8_t delay;
+    uint8_t sound;
+    uint8_t finished;
+    uint8_t fault; // Fault, with the faulting instruction's address and opcode
+    uint8_t halt;  // Halt reason
+    uint16_t fault_pc;
+    uint16_t fault_opcode;
+    uint16_t reserved2;
+};
+
+static_assert(sizeof(RunKey) == 40, "RunKey must stay 40 bytes");
+static_assert(sizeof(RunResult) == 64, "RunResult must stay 64 bytes");
+
+RunKey run_key(const uint8_t* rom, size_t size, const std::string& keys, size_t frames, size_t instructions,
+               Timing timing, Engine engine);
+RunResult run_result(const Chip8& chip8);
+
+// Hash of every library source, taken at build time. Empty when the build did not generate it.
+const char* library_version();
+
+// Results of earlier runs, one small file per run under <root>/<library version>/. Any
+// change to the library sources starts a new, empty directory, so stale results are never
+// read; old directories can be deleted at any time.
+class ResultCache {
+private:
+    std::string dir;
+
+    std::string path(const RunKey& key) const;
+
+public:
+    // Throws std::runtime_error if the directory cannot be created or the build has no
+    // library version to key on
+    explicit ResultCache(const std::string& root);
+
+    const std::string& directory() const { return dir; }
+    bool lookup(const RunKey& key, RunResult& result) const;
+    // False if the entry could not be written; the run's result is still valid
+    bool store(const RunKey& key, const RunResult& result) const;
+};
+
+#endif
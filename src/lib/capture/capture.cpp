@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include "capture.hpp"
+
+bool capture_format_for(const std::string& path, CaptureFormat& format) {
+    auto ends_with = [&](const char* ext) {
+        size_t n = strlen(ext);
+        return path.size() >= n && path.compare(path.size() - n, n, ext) == 0;
+    };
+    if (ends_with(".y4m")) format = CaptureFormat::Y4M;
+    else if (ends_with(".gif")) format = CaptureFormat::GIF;
+    else return false;
+    return true;
+}
+
+// Expand packed rows to one byte per output pixel
+static void expand_bytes(const uint64_t* rows, int scale, uint8_t on, uint8_t off, uint8_t* out) {
+    const int w = DISPLAY_WIDTH * scale;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        uint8_t* line = out + static_cast<size_t>(y) * scale * w;
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            uint8_t v = (rows[y] & (0x8000000000000000ull >> x)) ? on : off;
+            memset(line + x * scale, v, scale);
+        }
+        for (int s = 1; s < scale; s++) memcpy(line + s * w, line, w);
+    }
+}
+
+// Raw YUV4MPEG2, 4:4:4 so every plane has the full resolution
+class Y4MEncoder: public FrameEncoder {
+private:
+    std::ofstream out;
+    int scale;
+    std::vector<uint8_t> plane;
+    std::vector<uint8_t> chroma;
+
+public:
+    Y4MEncoder(const std::string& path, int scale, int fps): out(path, std::ios::binary), scale(scale) {
+        if (!out) throw std::runtime_error("Failed to open capture file " + path);
+        size_t n = static_cast<size_t>(DISPLAY_WIDTH) * DISPLAY_HEIGHT * scale * scale;
+        plane.resize(n);
+        chroma.assign(n, 128);
+        out << "YUV4MPEG2 W" << DISPLAY_WIDTH * scale << " H" << DISPLAY_HEIGHT * scale
+            << " F" << fps << ":1 Ip A1:1 C444\n";
+    }
+
+    void write(const uint64_t* rows) override {
+        expand_bytes(rows, scale, 235, 16, plane.data());
+        out << "FRAME\n";
+        out.write(reinterpret_cast<const char*>(plane.data()), plane.size());
+        out.write(reinterpret_cast<const char*>(chroma.data()), chroma.size());
+        out.write(reinterpret_cast<const char*>(chroma.data()), chroma.size());
+    }
+};
+
+// Animated GIF with a two colour palette. Runs of identical frames are merged into one
+// image with a longer delay, which is most of a CHIP-8 recording.
+class GifEncoder: public FrameEncoder {
+private:
+    static constexpr int min_code_size = 2; // Smallest the format allows
+    static constexpr int clear_code = 1 << min_code_size;
+    static constexpr int end_code = clear_code + 1;
+    static constexpr int max_codes = 4096;
+    // Viewers show frames with a delay under 2 cs for 10 cs, so a shorter frame is
+    // replaced by the next one, which takes over its time
+    static constexpr size_t min_delay_cs = 2;
+
+    std::ofstream out;
+    int scale;
+    int fps;
+    std::vector<uint8_t> pixels;
+    std::vector<uint16_t> children; // LZW dictionary: code * 4 + pixel -> code, 0 if absent
+    uint64_t pending[DISPLAY_HEIGHT]{};
+    size_t pending_frames = 0;
+    size_t total_frames = 0;
+    size_t total_cs = 0; // Centiseconds of delay written so far
+
+    // Bit packer into 255-byte sub-blocks
+    uint8_t block[256];
+    int block_len = 0;
+    uint32_t bit_buf = 0;
+    int bit_count = 0;
+
+    void put16(uint16_t v) {
+        out.put(static_cast<char>(v & 0xFF));
+        out.put(static_cast<char>(v >> 8));
+    }
+
+    void flush_block() {
+        if (block_len == 0) return;
+        out.put(static_cast<char>(block_len));
+        out.write(reinterpret_cast<const char*>(block), block_len);
+        block_len = 0;
+    }
+
+    void emit(int code, int code_size) {
+        bit_buf |= static_cast<uint32_t>(code) << bit_count;
+        bit_count += code_size;
+        while (bit_count >= 8) {
+            block[block_len++] = static_cast<uint8_t>(bit_buf & 0xFF);
+            if (block_len == 255) flush_block();
+            bit_buf >>= 8;
+            bit_count -= 8;
+        }
+    }
+
+    void encode_image(const uint8_t* px, size_t n) {
+        out.put(static_cast<char>(min_code_size));
+        std::fill(children.begin(), children.end(), 0);
+        int next = end_code + 1;
+        int code_size = min_code_size + 1;
+        emit(clear_code, code_size);
+
+        int prefix = px[0];
+        for (size_t i = 1; i < n; i++) {
+            uint16_t& child = children[prefix * 4 + px[i]];
+            if (child) {
+                prefix = child;
+                continue;
+            }
+            emit(prefix, code_size);
+            if (next < max_codes) {
+                child = static_cast<uint16_t>(next++);
+                if (next > (1 << code_size) && code_size < 12) code_size++;
+            } else {
+                emit(clear_code, code_size);
+                std::fill(children.begin(), children.end(), 0);
+                next = end_code + 1;
+                code_size = min_code_size + 1;
+            }
+            prefix = px[i];
+        }
+        emit(prefix, code_size);
+        emit(end_code, code_size);
+        if (bit_count > 0) emit(0, 8 - bit_count);
+        flush_block();
+        out.put(0);
+    }
+
+    // Centiseconds the pending image would be shown for if written now
+    size_t pending_delay() const {
+        return (total_frames + pending_frames) * 100 / fps - total_cs;
+    }
+
+    void flush_pending() {
+        if (pending_frames == 0) return;
+        size_t delay = pending_delay();
+        total_frames += pending_frames;
+        total_cs += delay;
+        pending_frames = 0;
+
+        // Graphic control extension: keep the previous image, delay in centiseconds
+        out.put(0x21); out.put(static_cast<char>(0xF9)); out.put(4);
+        out.put(0x04);
+        put16(static_cast<uint16_t>(std::min<size_t>(delay, 0xFFFF)));
+        out.put(0); out.put(0);
+
+        // Image descriptor covering the whole screen, no local colour table
+        out.put(0x2C);
+        put16(0); put16(0);
+        put16(static_cast<uint16_t>(DISPLAY_WIDTH * scale));
+        put16(static_cast<uint16_t>(DISPLAY_HEIGHT * scale));
+        out.put(0);
+
+        expand_bytes(pending, scale, 1, 0, pixels.data());
+        encode_image(pixels.data(), pixels.size());
+    }
+
+public:
+    GifEncoder(const std::string& path, int scale, int fps)
+        : out(path, std::ios::binary), scale(scale), fps(fps) {
+        if (!out) throw std::runtime_error("Failed to open capture file " + path);
+        pixels.resize(static_cast<size_t>(DISPLAY_WIDTH) * DISPLAY_HEIGHT * scale * scale);
+        children.resize(max_codes * 4);
+
+        out.write("GIF89a", 6);
+        put16(static_cast<uint16_t>(DISPLAY_WIDTH * scale));
+        put16(static_cast<uint16_t>(DISPLAY_HEIGHT * scale));
+        out.put(static_cast<char>(0x81)); // Global colour table of 4 entries
+        out.put(0); out.put(0);
+        const uint8_t palette[12] = {0, 0, 0, 255, 255, 255, 0, 0, 0, 0, 0, 0};
+        out.write(reinterpret_cast<const char*>(palette), sizeof(palette));
+
+        // Loop forever
+        out.put(0x21); out.put(static_cast<char>(0xFF)); out.put(11);
+        out.write("NETSCAPE2.0", 11);
+        out.put(3); out.put(1); put16(0); out.put(0);
+    }
+
+    void write(const uint64_t* rows) override {
+        if (pending_frames > 0 && memcmp(rows, pending, sizeof(pending)) == 0) {
+            pending_frames++;
+            return;
+        }
+        if (pending_delay() >= min_delay_cs) flush_pending();
+        memcpy(pending, rows, sizeof(pending));
+        pending_frames++;
+    }
+
+    void finish() override {
+        flush_pending();
+        out.put(0x3B);
+        out.flush();
+    }
+};
+
+Capture::Capture(const std::string& path, CaptureFormat format, int scale, int fps) {
+    scale = std::max(scale, 1);
+    if (format == CaptureFormat::Y4M) encoder = std::make_unique<Y4MEncoder>(path, scale, fps);
+    else encoder = std::make_unique<GifEncoder>(path, scale, fps);
+    queue.resize(CAPTURE_QUEUE_SIZE);
+    worker = std::thread(&Capture::run, this);
+}
+
+Capture::~Capture() {
+    stopping.store(true, std::memory_order_release);
+    wake.notify_one();
+    worker.join();
+    encoder->finish();
+}
+
+bool Capture::push(const uint64_t* rows, bool wait) {
+    size_t h = head.load(std::memory_order_relaxed);
+    while (h - tail.load(std::memory_order_acquire) == CAPTURE_QUEUE_SIZE) {
+        if (!wait) {
+            n_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        wake.notify_one();
+        std::this_thread::yield();
+    }
+    memcpy(queue[h % CAPTURE_QUEUE_SIZE].rows, rows, sizeof(Frame::rows));
+    head.store(h + 1, std::memory_order_release);
+    wake.notify_one();
+    return true;
+}
+
+void Capture::run() {
+    for (;;) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            if (stopping.load(std::memory_order_acquire)) {
+                // Re-check so frames pushed right before the stop request are not lost
+                if (t == head.load(std::memory_order_acquire)) return;
+                continue;
+            }
+            // The emulator never takes the lock, so poll with a timeout instead of
+            // relying on a notification that may race the check above
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(5));
+            continue;
+        }
+        encoder->write(queue[t % CAPTURE_QUEUE_SIZE].rows);
+        tail.store(t + 1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SRC_LIB_CAPTURE_HPP
+#define SRC_LIB_CAPTURE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../chip8/chip8.hpp"
+
+#define CAPTURE_QUEUE_SIZE 1024 // Frames buffered between the emulator and the encoder
+
+enum class CaptureFormat { Y4M, GIF };
+
+// Picks the format from the file extension (.y4m / .gif)
+bool capture_format_for(const std::string& path, CaptureFormat& format);
+
+// Writes packed display frames to a video file. Implementations run on the capture thread.
+class FrameEncoder {
+public:
+    virtual ~FrameEncoder() = default;
+    virtual void write(const uint64_t* rows) = 0;
+    virtual void finish() {}
+};
+
+// Records presented frames on a background thread. The emulator only copies the packed
+// 256-byte display into a lock-free queue, the expansion and encoding happen elsewhere.
+class Capture {
+private:
+    struct Frame {
+        uint64_t rows[DISPLAY_HEIGHT];
+    };
+
+    std::vector<Frame> queue;
+    std::atomic<size_t> head{0}; // Next slot written by the emulator
+    std::atomic<size_t> tail{0}; // Next slot read by the encoder
+    std::atomic<size_t> n_dropped{0};
+    std::atomic<bool> stopping{false};
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::unique_ptr<FrameEncoder> encoder;
+    std::thread worker;
+
+    void run();
+
+public:
+    // Throws std::runtime_error if the output file cannot be created
+    Capture(const std::string& path, CaptureFormat format, int scale, int fps);
+    ~Capture();
+
+    Capture(const Capture&) = delete;
+    Capture& operator=(const Capture&) = delete;
+
+    // Queue a frame. When the queue is full the frame is dropped (counted) unless `wait`
+    // is set, in which case the caller blocks until the encoder catches up.
+    bool push(const uint64_t* rows, bool wait = false);
+
+    size_t frames() const { return head.load(std::memory_order_relaxed); }
+    size_t dropped() const { return n_dropped.load(std::memory_order_relaxed); }
+};
+
+#endif
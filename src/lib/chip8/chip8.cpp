@@ -1,50 +1,249 @@
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <cstring>
 #include <fstream>
 #include "../instructions/parser.hpp"
+#include "../rom/rom.hpp"
 #include "chip8.hpp"
 #include "../utils/format.hpp"
+#include "../utils/hash.hpp"
 
-void Chip8::setFont() {
-    static const uint8_t fontset[80] = {
-        0xF0,0x90,0x90,0x90,0xF0, //0
-        0x20,0x60,0x20,0x20,0x70, //1
-        0xF0,0x10,0xF0,0x80,0xF0, //2
-        0xF0,0x10,0xF0,0x10,0xF0, //3
-        0x90,0x90,0xF0,0x10,0x10, //4
-        0xF0,0x80,0xF0,0x10,0xF0, //5
-        0xF0,0x80,0xF0,0x90,0xF0, //6
-        0xF0,0x10,0x20,0x40,0x40, //7
-        0xF0,0x90,0xF0,0x90,0xF0, //8
-        0xF0,0x90,0xF0,0x10,0xF0, //9
-        0xF0,0x90,0xF0,0x90,0x90, //A
-        0xE0,0x90,0xE0,0x90,0xE0, //B
-        0xF0,0x80,0x80,0x80,0xF0, //C
-        0xE0,0x90,0x90,0x90,0xE0, //D
-        0xF0,0x80,0xF0,0x80,0xF0, //E
-        0xF0,0x80,0xF0,0x80,0x80  //F
-    };
-    memcpy(memory + 0x050, fontset, 80);
+bool parse_engine(const std::string& name, Engine& engine) {
+    if (name == "reference") engine = Engine::Reference;
+    else if (name == "switch") engine = Engine::Switch;
+    else if (name == "predecoded") engine = Engine::Predecoded;
+    else return false;
+    return true;
 }
 
-bool Chip8::loadRom(const std::string& path) {
-    std::ifstream in(path, std::ios::binary);
-    if (!in) return false;
-    in.read(reinterpret_cast<char*>(memory + MEM_START), MEM_SIZE - MEM_START);
-    rom_end = MEM_START + static_cast<uint16_t>(in.gcount());
+const char* engine_name(Engine engine) {
+    switch (engine) {
+        case Engine::Reference: return "reference";
+        case Engine::Switch: return "switch";
+        case Engine::Predecoded: return "predecoded";
+    }
+    return "unknown";
+}
+
+const char* fault_name(Fault fault) {
+    switch (fault) {
+        case Fault::None: return "none";
+        case Fault::StackUnderflow: return "stack underflow";
+        case Fault::StackOverflow: return "stack overflow";
+    }
+    return "unknown";
+}
+
+const char* halt_name(Halt halt) {
+    switch (halt) {
+        case Halt::None: return "running";
+        case Halt::SelfJump: return "self jump";
+        case Halt::Fault: return "fault";
+        case Halt::InstructionBudget: return "instruction budget";
+        case Halt::FrameBudget: return "frame budget";
+    }
+    return "unknown";
+}
+
+std::string Chip8::fault_message() const {
+    if (fault_code == Fault::None) return "";
+    return fmt("%s at %s (%s)", fault_name(fault_code), hex(fault_addr, 3), hex(fault_inst, 4));
+}
+
+void Chip8::unknown_opcode(uint16_t opcode) {
+    // A ROM spinning on bad opcodes would otherwise print one line per instruction
+    if (unknown_count < UNKNOWN_OPCODE_REPORTS) {
+        std::cerr << "Unknown instruction: " << hex(opcode, 4) << " at " << hex((pc - 2) & MEM_MASK, 3) << "\n";
+    } else if (unknown_count == UNKNOWN_OPCODE_REPORTS) {
+        std::cerr << "Further unknown instructions not reported\n";
+    }
+    unknown_count++;
+}
+
+static const uint8_t fontset[80] = {
+    0xF0,0x90,0x90,0x90,0xF0, //0
+    0x20,0x60,0x20,0x20,0x70, //1
+    0xF0,0x10,0xF0,0x80,0xF0, //2
+    0xF0,0x10,0xF0,0x10,0xF0, //3
+    0x90,0x90,0xF0,0x10,0x10, //4
+    0xF0,0x80,0xF0,0x10,0xF0, //5
+    0xF0,0x80,0xF0,0x90,0xF0, //6
+    0xF0,0x10,0x20,0x40,0x40, //7
+    0xF0,0x90,0xF0,0x90,0xF0, //8
+    0xF0,0x90,0xF0,0x10,0xF0, //9
+    0xF0,0x90,0xF0,0x90,0x90, //A
+    0xE0,0x90,0xE0,0x90,0xE0, //B
+    0xF0,0x80,0x80,0x80,0xF0, //C
+    0xE0,0x90,0x90,0x90,0xE0, //D
+    0xF0,0x80,0xF0,0x80,0xF0, //E
+    0xF0,0x80,0xF0,0x80,0x80  //F
+};
+
+std::shared_ptr<const Chip8::Image> Chip8::build_image(const uint8_t* rom, size_t size, bool predecode) {
+    auto image = std::make_shared<Image>();
+    memcpy(image->memory + FONT_START, fontset, sizeof(fontset));
+    if (size) memcpy(image->memory + MEM_START, rom, size);
+    image->rom_end = MEM_START + static_cast<uint16_t>(size);
+    // Every other byte is zero and has no key
+    for (uint16_t addr = FONT_START; addr < FONT_START + sizeof(fontset); addr++) {
+        image->memory_keys ^= memory_key(addr, image->memory[addr]);
+    }
+    for (uint16_t addr = MEM_START; addr < image->rom_end; addr++) image->memory_keys ^= memory_key(addr, image->memory[addr]);
+    if (predecode) {
+        image->predecoded.resize(MEM_SIZE);
+        for (uint32_t addr = 0; addr < MEM_SIZE; addr++) {
+            image->predecoded[addr] = DecodedInst((image->memory[addr] << 8) | image->memory[(addr + 1) & MEM_MASK]);
+        }
+    }
+    return image;
+}
+
+Chip8::Chip8() {
+    // Every machine starts from the same font-only image
+    static const std::shared_ptr<const Image> power_on = build_image(nullptr, 0, false);
+    image = power_on;
+    reset();
+}
+
+void Chip8::reset() {
+    memcpy(memory, image->memory, sizeof(memory));
+    memory_keys = image->memory_keys;
+    rom_end = image->rom_end;
+    memset(stack, 0, sizeof(stack));
+    memset(V, 0, sizeof(V));
+    memset(pattern, 0, sizeof(pattern));
+    clear_display();
     pc = MEM_START;
+    I = 0;
+    sp = 0;
+    delay = 0;
+    sound = 0;
+    pitch = 64;
+    pattern_gen = 0;
+    tick = 0;
+    rng = RNG_SEED;
+    frame_cycles = 0;
+    vip_frames = 0;
+    held_key = -1;
+    halt_reason = Halt::None;
+    fault_code = Fault::None;
+    fault_addr = 0;
+    fault_inst = 0;
+    unknown_count = 0;
+    n_sound_edges = 0;
+    if (engine != Engine::Predecoded) return;
+    if (image->predecoded.empty()) predecode();
+    else predecoded = image->predecoded;
+}
+
+void Chip8::set_engine(Engine e) {
+    engine = e;
+    if (engine == Engine::Predecoded) predecode();
+    else predecoded.clear();
+}
+
+void Chip8::predecode() {
+    predecoded.resize(MEM_SIZE);
+    for (uint32_t addr = 0; addr < MEM_SIZE; addr++) {
+        predecoded[addr] = DecodedInst((memory[addr] << 8) | memory[(addr + 1) & MEM_MASK]);
+    }
+}
+
+void Chip8::poke(uint16_t addr, uint8_t value) {
+    addr &= MEM_MASK;
+    store(addr, value);
+    if (predecoded.empty()) return;
+    for (uint16_t a : {static_cast<uint16_t>((addr - 1) & MEM_MASK), addr}) {
+        predecoded[a] = DecodedInst((memory[a] << 8) | memory[(a + 1) & MEM_MASK]);
+    }
+}
+
+bool Chip8::loadRom(const std::string& path) {
+    try {
+        // Map instead of streaming; images larger than memory are truncated as before
+        MappedRom rom(path);
+        return loadRom(rom.data(), std::min<size_t>(rom.size(), MEM_SIZE - MEM_START));
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+bool Chip8::loadRom(const uint8_t* data, size_t size) {
+    if (size > MEM_SIZE - MEM_START) return false;
+    image = build_image(data, size, engine == Engine::Predecoded);
+    reset();
     return true;
 }
 
-void Chip8::step(std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+uint64_t Chip8::display_hash() const {
+    // FNV-1a over the packed rows, one 64-bit word at a time
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        hash ^= display[y];
+        hash *= 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// Registers, stack and audio state: small enough to hash in full every time
+static uint64_t hash_small_state(const uint8_t* V, const uint16_t* stack, const uint8_t* pattern, const uint64_t* regs,
+                                 size_t n_regs) {
+    uint64_t hash = hash_bytes(V, N_REG);
+    hash = hash_bytes(stack, 16 * sizeof(uint16_t), hash);
+    hash = hash_bytes(pattern, 16, hash);
+    return hash_bytes(regs, n_regs * sizeof(uint64_t), hash);
+}
+
+uint64_t Chip8::state_hash() const {
+    const uint64_t regs[] = {memory_keys, display_keys, I, pc, sp, delay, sound, rng,
+                             static_cast<uint64_t>(held_key + 1), frame_cycles, tick % TICKS_PER_FRAME, pitch,
+                             static_cast<uint64_t>(fault_code), static_cast<uint64_t>(halt_reason)};
+    return hash_small_state(V, stack, pattern, regs, sizeof(regs) / sizeof(regs[0]));
+}
+
+uint64_t Chip8::full_state_hash() const {
+    uint64_t mem = 0;
+    for (uint16_t addr = 0; addr < MEM_SIZE; addr++) mem ^= memory_key(addr, memory[addr]);
+    uint64_t rows = 0;
+    for (uint8_t y = 0; y < DISPLAY_HEIGHT; y++) rows ^= row_key(y, display[y]);
+    const uint64_t regs[] = {mem, rows, I, pc, sp, delay, sound, rng,
+                             static_cast<uint64_t>(held_key + 1), frame_cycles, tick % TICKS_PER_FRAME, pitch,
+                             static_cast<uint64_t>(fault_code), static_cast<uint64_t>(halt_reason)};
+    return hash_small_state(V, stack, pattern, regs, sizeof(regs) / sizeof(regs[0]));
+}
+
+void Chip8::step(uint16_t keydown) {
     if (finished()) return;
-    if (tick % 20 && delay > 0) --delay;
-    if (tick % 20 && sound > 0) --sound;
+    if (timing == Timing::Vip) step_vip(keydown);
+    else step_fixed(keydown);
+    // Budgets halt the machine right after the instruction that uses them up
+    if (halt_reason != Halt::None) return;
+    if (tick >= tick_limit) halt_reason = Halt::InstructionBudget;
+    else if (frame_count() >= frame_limit) halt_reason = Halt::FrameBudget;
+}
+
+void Chip8::step_fixed(uint16_t keydown) {
+    // Per tick rather than per frame, skipping the frame's first; the goldens depend on it
+    if (tick % TICKS_PER_FRAME && delay > 0) --delay;
+    if (tick % TICKS_PER_FRAME && sound > 0) set_sound(sound - 1);
     tick++;
 
-    uint16_t opcode = (memory[pc] << 8) | memory[pc + 1];
+    if (engine == Engine::Predecoded) {
+        // No check for writes to code: the program was analysed not to make any
+        const DecodedInst inst = predecoded[pc & MEM_MASK];
+        pc += 2;
+        execute_switch(inst.opcode, inst.kind, keydown);
+        return;
+    }
+    uint16_t opcode = (memory[pc & MEM_MASK] << 8) | memory[(pc + 1) & MEM_MASK];
+    if (engine == Engine::Switch) {
+        pc += 2;
+        execute_switch(opcode, decode(opcode), keydown);
+        return;
+    }
     std::unique_ptr<Inst> inst = Chip8Parser::parse(opcode);
     pc += 2;
-    inst->execute(*this, frame_buffer, frame_width, frame_height, keydown);
+    inst->execute(*this, keydown);
 }
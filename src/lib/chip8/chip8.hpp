@@ -1,21 +1,96 @@
 #ifndef SRC_CHIP8_HPP
 #define SRC_CHIP8_HPP
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <cstdint>
 #include <cstring>
 #include <fstream>
+#include "../instructions/decode.hpp"
+#include "../utils/hash.hpp"
+#include "../utils/trace.hpp"
 
 #define MEM_SIZE 4096
+#define MEM_MASK (MEM_SIZE - 1) // Addresses wrap around the 4 KB address space
 #define FONT_START 0x050
 #define MEM_START 0x200
 #define N_REG 16
+#define DISPLAY_WIDTH 64
+#define DISPLAY_HEIGHT 32
+#define TICKS_PER_FRAME 20 // Instructions per frame under Timing::Fixed
+#define FRAMES_PER_SECOND 50 // The UI runs 1000 instructions per second
+#define RNG_SEED 0x2545F491
+#define VIP_FRAME_CYCLES 3668   // COSMAC VIP machine cycles per 60 Hz frame: 1.76 MHz, 8 clocks each
+#define VIP_DISPLAY_CYCLES 1100 // Of those, taken by the display DMA and the interrupt routine
+#define VIP_FRAMES_PER_SECOND 60
+#define UNKNOWN_OPCODE_REPORTS 8 // Unknown opcodes reported on stderr per machine before going quiet
+#define ZOBRIST_SEED 0x5851f42d4c957f2dull // Salts the per-byte and per-row state hash keys
+#define SOUND_EDGES 8 // Sound timer starts and stops remembered for the audio output
 
 class Inst;
 
+// Interpreter cores. All of them must match Reference (Inst::execute) exactly.
+enum class Engine {
+    Reference, // Decode through Chip8Parser and dispatch via Inst::execute
+    Switch,    // Decode and execute in one switch, no allocation
+    Predecoded, // Switch over a table decoded at load time. Only valid for programs that
+                // never overwrite their code; see fastest_safe_engine in analysis/analysis.hpp
+};
+
+bool parse_engine(const std::string& name, Engine& engine);
+const char* engine_name(Engine engine);
+
+// How instructions are paced against the timers and the display
+enum class Timing {
+    Fixed, // Every instruction is one tick and TICKS_PER_FRAME ticks are a frame. The timers
+           // count down on every tick but the first of each frame: 19 times per frame, not once
+    Vip,   // COSMAC VIP machine cycles per instruction and 60 Hz frames: DXYN waits for the
+           // vertical blank and FX0A completes when the key is released. See chip8/timing.cpp
+};
+
+bool parse_timing(const std::string& name, Timing& timing);
+const char* timing_name(Timing timing);
+
+// Why a machine stopped itself. A faulted machine stays halted at the faulting instruction
+// until it is reset or a ROM is loaded.
+enum class Fault : uint8_t {
+    None,
+    StackUnderflow, // RET with an empty stack
+    StackOverflow,  // CALL with all 16 entries in use
+};
+
+const char* fault_name(Fault fault);
+
+// Why a machine stopped running. Once halted, step() does nothing until reset or a new ROM.
+enum class Halt : uint8_t {
+    None,
+    SelfJump,          // JP to itself with both timers at zero: nothing can change any more
+    Fault,             // See Chip8::fault()
+    InstructionBudget, // set_budget's instruction count was used up
+    FrameBudget,       // set_budget's frame count was used up
+};
+
+const char* halt_name(Halt halt);
+
+// The sound timer started (`on`) or ran out, after the instruction that ended at `tick`
+struct SoundEdge {
+    size_t tick;
+    bool on;
+};
+
 class Chip8 {
 private:
+    // Memory as loadRom left it: font and ROM. Shared with copies of the machine (and, for
+    // the font-only power-on image, by every machine), and never written after it is built.
+    struct Image {
+        uint8_t memory[MEM_SIZE]{};
+        uint64_t memory_keys = 0;
+        uint16_t rom_end = MEM_START;
+        std::vector<DecodedInst> predecoded; // Only when loaded for Engine::Predecoded
+    };
+
     uint8_t memory[MEM_SIZE]{}; // 4096 bytes RAM
     uint16_t pc = MEM_START;
     uint16_t I = 0;
@@ -24,19 +99,161 @@ private:
     uint8_t delay = 0;
     uint8_t sound = 0;
     uint8_t V[N_REG]{}; // V0..VF
+    uint8_t pattern[16]{}; // XO-CHIP audio pattern buffer
+    uint8_t pitch = 64; // XO-CHIP pitch register
+    uint32_t pattern_gen = 0; // Bumped on every pattern load, 0 = plain CHIP-8 beep
+    uint64_t display[DISPLAY_HEIGHT]{}; // One packed row per line, MSB is the leftmost pixel
     uint16_t rom_end = MEM_START;
     size_t tick = 0;
+    uint32_t rng = RNG_SEED; // xorshift32 state for RND, per machine so runs are reproducible
+    Engine engine = Engine::Reference;
+    std::vector<DecodedInst> predecoded; // Every address of memory, filled for Engine::Predecoded
+    Timing timing = Timing::Fixed;
+    uint32_t frame_cycles = 0; // Machine cycles used so far in the current frame (Timing::Vip)
+    size_t vip_frames = 0;     // Completed frames (Timing::Vip)
+    int8_t held_key = -1;      // Key FX0A saw pressed and waits to be released (Timing::Vip)
+    uint64_t memory_keys = 0;  // XOR of memory_key over every byte, kept up to date by store()
+    uint64_t display_keys = 0; // XOR of row_key over every row, kept up to date by set_row()
+    Halt halt_reason = Halt::None;
+    size_t tick_limit = SIZE_MAX;  // Instruction budget, see set_budget
+    size_t frame_limit = SIZE_MAX; // Frame budget
+    Fault fault_code = Fault::None;
+    uint16_t fault_addr = 0;   // Address of the faulting instruction
+    uint16_t fault_inst = 0;   // Its opcode
+    size_t unknown_count = 0;  // Unknown opcodes executed, as no-ops
+    SoundEdge sound_log[SOUND_EDGES]{}; // Ring of the latest edges, see sound_edge()
+    size_t n_sound_edges = 0;
+    std::shared_ptr<const Image> image; // What reset() restores
+
+    uint8_t random_byte() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return static_cast<uint8_t>(rng);
+    }
+    // Zobrist-style keys: zero for a clear byte or row, so a cleared machine hashes to 0
+    static uint64_t memory_key(uint16_t addr, uint8_t value) {
+        return value ? mix64((static_cast<uint64_t>(addr) << 8 | value) + ZOBRIST_SEED) : 0;
+    }
+    static uint64_t row_key(uint8_t y, uint64_t row) {
+        return row ? mix64(mix64(row) + y + ZOBRIST_SEED) : 0;
+    }
+    // Every write to memory and the display goes through these
+    void store(uint16_t addr, uint8_t value) {
+        addr &= MEM_MASK;
+        memory_keys ^= memory_key(addr, memory[addr]) ^ memory_key(addr, value);
+        memory[addr] = value;
+    }
+    void set_row(uint8_t y, uint64_t row) {
+        display_keys ^= row_key(y, display[y]) ^ row_key(y, row);
+        display[y] = row;
+    }
+    void clear_display() {
+        std::fill(display, display + DISPLAY_HEIGHT, 0);
+        display_keys = 0;
+    }
+    // Every write to the sound timer goes through this, to log when the beep starts and stops
+    void set_sound(uint8_t value) {
+        if ((value > 0) != (sound > 0)) sound_log[n_sound_edges++ % SOUND_EDGES] = {tick, value > 0};
+        sound = value;
+    }
+    // Called after pc has moved past `opcode`; leaves pc on the faulting instruction
+    void raise_fault(Fault fault, uint16_t opcode) {
+        pc -= 2;
+        halt_reason = Halt::Fault;
+        fault_code = fault;
+        fault_addr = pc;
+        fault_inst = opcode;
+    }
+    void unknown_opcode(uint16_t opcode);
+    // JP: a jump to itself with no timer running can never be left, so the machine halts
+    void jump(uint16_t target) {
+        if (target == ((pc - 2) & MEM_MASK) && delay == 0 && sound == 0) halt_reason = Halt::SelfJump;
+        pc = target;
+    }
+    static std::shared_ptr<const Image> build_image(const uint8_t* rom, size_t size, bool predecode);
+    void execute_switch(uint16_t opcode, OpKind kind, uint16_t keydown);
+    void predecode();
+    void step_fixed(uint16_t keydown);
+    void step_vip(uint16_t keydown);
+    void wait_key_release(uint8_t x, uint16_t keydown);
 
 public:
-    Chip8() { setFont(); }
-    void setFont();
+    Chip8();
+    // Back to the state right after the last loadRom, or power-on (font only) if there was
+    // none: memory is restored with one copy, and the registers, display, counters and fault
+    // are cleared. Engine, timing and budgets are kept.
+    void reset();
+    // Load a ROM and reset(). False, with the machine unchanged, if the file cannot be read.
+    // A file larger than the MEM_SIZE - MEM_START bytes above MEM_START is truncated to fit.
     bool loadRom(const std::string& path);
+    // False, with the machine unchanged, if the image does not fit above MEM_START
+    bool loadRom(const uint8_t* data, size_t size);
     bool finished() const {
-        return pc >= rom_end;
+        return halt_reason != Halt::None;
     };
-    void step(std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown);
+    Halt halt() const { return halt_reason; }
+    // Halt after `instructions` instructions or `frames` frames in total, 0 for no limit.
+    // Kept across reset() and loadRom(), like the engine and timing.
+    void set_budget(size_t instructions, size_t frames) {
+        tick_limit = instructions ? instructions : SIZE_MAX;
+        frame_limit = frames ? frames : SIZE_MAX;
+    }
+    void step(uint16_t keydown);
+    // One frame: TICKS_PER_FRAME instructions, or a VIP frame's worth of cycles
+    void run_frame(uint16_t keydown) {
+        TRACE_SPAN("run_frame");
+        if (timing == Timing::Vip) {
+            for (size_t frame = vip_frames; vip_frames == frame && !finished();) step(keydown);
+            return;
+        }
+        for (int i = 0; i < TICKS_PER_FRAME; i++) step(keydown);
+    }
+    void set_engine(Engine e);
+    Engine get_engine() const { return engine; }
+    void set_timing(Timing t);
+    Timing get_timing() const { return timing; }
+    int frames_per_second() const { return timing == Timing::Vip ? VIP_FRAMES_PER_SECOND : FRAMES_PER_SECOND; }
+    void seed(uint32_t s) { rng = s ? s : 1; }
     void quit() {};
     bool is_beeping() const { return sound > 0; }
+    // Edges of is_beeping() since reset, numbered from 0; only the last SOUND_EDGES are kept.
+    // Lets the audio output gate samples at the instruction the beep changed.
+    size_t sound_edges() const { return n_sound_edges; }
+    const SoundEdge& sound_edge(size_t i) const { return sound_log[i % SOUND_EDGES]; }
+    const uint8_t* audio_pattern() const { return pattern; }
+    uint8_t audio_pitch() const { return pitch; }
+    uint32_t audio_pattern_gen() const { return pattern_gen; }
+    const uint64_t* display_rows() const { return display; }
+    size_t frame_count() const { return timing == Timing::Vip ? vip_frames : tick / TICKS_PER_FRAME; }
+    uint64_t display_hash() const;
+    // Everything that decides what the machine does next: memory, registers, stack, timers,
+    // display and RNG. Equal hashes mean equivalent states for search and replay checks.
+    // Memory and display are hashed incrementally as they are written, so this is O(1).
+    uint64_t state_hash() const;
+    // The same hash recomputed from every byte, to check the incremental one
+    uint64_t full_state_hash() const;
+
+    // Read-only views of the machine state, for tools that inspect or compare machines
+    const uint8_t* ram() const { return memory; }
+    const uint8_t* registers() const { return V; }
+    uint16_t index() const { return I; }
+    uint16_t program_counter() const { return pc; }
+    uint8_t stack_pointer() const { return sp; }
+    const uint16_t* call_stack() const { return stack; }
+    uint8_t delay_timer() const { return delay; }
+    uint8_t sound_timer() const { return sound; }
+    uint16_t rom_size() const { return rom_end - MEM_START; }
+    size_t ticks() const { return tick; }
+    Fault fault() const { return fault_code; }
+    uint16_t fault_pc() const { return fault_addr; }
+    uint16_t fault_opcode() const { return fault_inst; }
+    // "stack underflow at 0x2a4 (0x00ee)", or empty when the machine has not faulted
+    std::string fault_message() const;
+    size_t unknown_opcodes() const { return unknown_count; }
+
+    // Memory write from a debugger; keeps the predecoded table in step with memory
+    void poke(uint16_t addr, uint8_t value);
 
     void memdump(std::ostream& os = std::cout) const {
         os << "pc: " << std::hex << pc << ", I: " << I << ", sp: " << std::dec << static_cast<int>(sp) << "\n";
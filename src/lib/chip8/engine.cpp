@@ -0,0 +1,184 @@
+#include <algorithm>
+#include "chip8.hpp"
+#include "../instructions/decode.hpp"
+
+// Switch and predecoded engines: execute straight from the decoded kind without building
+// an Inst. Every case mirrors the matching Inst::execute in instructions.cpp and must stay
+// in sync with it; the differential runner (chip8-diff) checks this.
+void Chip8::execute_switch(uint16_t opcode, OpKind kind, uint16_t keydown) {
+    const uint8_t X = (opcode >> 8) & 0x0F;
+    const uint8_t Y = (opcode >> 4) & 0x0F;
+    const uint8_t NN = opcode & 0x00FF;
+    const uint16_t NNN = opcode & 0x0FFF;
+
+    switch (kind) {
+    case OpKind::Cls:
+        clear_display();
+        return;
+    case OpKind::Ret:
+        if (sp == 0) {
+            raise_fault(Fault::StackUnderflow, opcode);
+            return;
+        }
+        sp--;
+        pc = stack[sp];
+        return;
+    case OpKind::Jp:
+        jump(NNN);
+        return;
+    case OpKind::Call:
+        if (sp >= 16) {
+            raise_fault(Fault::StackOverflow, opcode);
+            return;
+        }
+        stack[sp] = pc;
+        sp++;
+        pc = NNN;
+        return;
+    case OpKind::Se:
+        if (V[X] == NN) pc += 2;
+        return;
+    case OpKind::Sne:
+        if (V[X] != NN) pc += 2;
+        return;
+    case OpKind::Sev:
+        if (V[X] == V[Y]) pc += 2;
+        return;
+    case OpKind::Snev:
+        if (V[X] != V[Y]) pc += 2;
+        return;
+    case OpKind::Ldv:
+        V[X] = NN;
+        return;
+    case OpKind::Addv:
+        V[X] += NN;
+        return;
+    case OpKind::Ldr:
+        V[X] = V[Y];
+        return;
+    case OpKind::Or:
+        V[X] |= V[Y];
+        V[0xF] = 0;
+        return;
+    case OpKind::And:
+        V[X] &= V[Y];
+        V[0xF] = 0;
+        return;
+    case OpKind::Xor:
+        V[X] ^= V[Y];
+        V[0xF] = 0;
+        return;
+    case OpKind::AddR: {
+        uint16_t sum = static_cast<uint16_t>(V[X]) + V[Y];
+        V[X] = sum & 0xFF;
+        V[0xF] = sum > 0xFF;
+        return;
+    }
+    case OpKind::Sub: {
+        uint8_t vf = V[X] >= V[Y];
+        V[X] = V[X] - V[Y];
+        V[0xF] = vf;
+        return;
+    }
+    case OpKind::Shr: {
+        uint8_t carry = V[Y] & 0x01;
+        V[X] = V[Y] >> 1;
+        V[0xF] = carry;
+        return;
+    }
+    case OpKind::Subn: {
+        uint8_t vf = V[Y] >= V[X];
+        V[X] = V[Y] - V[X];
+        V[0xF] = vf;
+        return;
+    }
+    case OpKind::Shl: {
+        uint8_t carry = (V[Y] & 0x80) >> 7;
+        V[X] = (V[Y] << 1) & 0xFF;
+        V[0xF] = carry;
+        return;
+    }
+    case OpKind::Ldi:
+        I = NNN;
+        return;
+    case OpKind::Jp0:
+        pc = NNN + V[0];
+        return;
+    case OpKind::Rnd:
+        V[X] = random_byte() & NN;
+        return;
+    case OpKind::Drw: {
+        uint8_t x_corr = V[X] % DISPLAY_WIDTH;
+        uint8_t y_corr = V[Y] % DISPLAY_HEIGHT;
+        uint8_t vf = 0;
+        for (uint8_t row = 0; row < (opcode & 0xF); ++row) {
+            uint64_t sprite_row = static_cast<uint64_t>(memory[(I + row) & MEM_MASK]) << 56;
+            if (x_corr) sprite_row = (sprite_row >> x_corr) | (sprite_row << (DISPLAY_WIDTH - x_corr));
+            uint8_t y = (y_corr + row) % DISPLAY_HEIGHT;
+            vf |= (display[y] & sprite_row) != 0;
+            set_row(y, display[y] ^ sprite_row);
+        }
+        V[0xF] = vf;
+        return;
+    }
+    case OpKind::Skp:
+        if (keydown & (1 << (V[X] & 0x0F))) pc += 2;
+        return;
+    case OpKind::Sknp:
+        if (!(keydown & (1 << (V[X] & 0x0F)))) pc += 2;
+        return;
+    case OpKind::Audio:
+        for (uint8_t i = 0; i < 16; ++i) pattern[i] = memory[(I + i) & MEM_MASK];
+        pattern_gen++;
+        return;
+    case OpKind::LdDt:
+        V[X] = delay;
+        return;
+    case OpKind::Key:
+        if (keydown == 0) {
+            pc -= 2;
+            return;
+        }
+        for (uint8_t key = 0; key < 16; ++key) {
+            if (keydown & (1 << key)) {
+                V[X] = key;
+                return;
+            }
+        }
+        return;
+    case OpKind::StDt:
+        delay = V[X];
+        return;
+    case OpKind::StSt:
+        set_sound(V[X]);
+        return;
+    case OpKind::AddI:
+        I += V[X];
+        return;
+    case OpKind::LdF:
+        I = 0x50 + (V[X] & 0x0F) * 5;
+        return;
+    case OpKind::Bcd: {
+        uint8_t value = V[X];
+        store(I + 2, value % 10);
+        value /= 10;
+        store(I + 1, value % 10);
+        value /= 10;
+        store(I, value % 10);
+        return;
+    }
+    case OpKind::Pitch:
+        pitch = V[X];
+        return;
+    case OpKind::Str:
+        for (uint8_t i = 0; i <= X; ++i) store(I++, V[i]);
+        return;
+    case OpKind::LdRm:
+        for (uint8_t i = 0; i <= X; ++i) V[i] = memory[I++ & MEM_MASK];
+        return;
+    case OpKind::Unknown:
+    case OpKind::Count:
+        break;
+    }
+    unknown_opcode(opcode);
+}
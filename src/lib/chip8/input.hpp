@@ -0,0 +1,53 @@
+#ifndef SRC_CHIP8_INPUT_HPP
+#define SRC_CHIP8_INPUT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+// Scripted keypad input for headless runs: a list of "frame:mask" events separated by
+// commas, e.g. "10:0x0002,14:0" holds key 1 from frame 10 until frame 14. The mask is
+// the same 16-bit keydown bitmap the UI passes to Chip8::step.
+class InputScript {
+private:
+    struct Event {
+        size_t frame;
+        uint16_t keydown;
+    };
+    std::vector<Event> events;
+    size_t cursor = 0;
+    uint16_t current = 0;
+
+public:
+    InputScript() = default;
+
+    // Throws std::invalid_argument on malformed scripts
+    explicit InputScript(const std::string& script) {
+        size_t pos = 0;
+        while (pos < script.size()) {
+            size_t end = script.find(',', pos);
+            if (end == std::string::npos) end = script.size();
+            std::string event = script.substr(pos, end - pos);
+            size_t colon = event.find(':');
+            if (colon == std::string::npos) throw std::invalid_argument("Bad input event: " + event);
+            Event e{std::stoul(event.substr(0, colon)), static_cast<uint16_t>(std::stoul(event.substr(colon + 1), nullptr, 0))};
+            if (!events.empty() && e.frame < events.back().frame) throw std::invalid_argument("Input events out of order: " + event);
+            events.push_back(e);
+            pos = end + 1;
+        }
+    }
+
+    // Keys held during `frame`. Frames must be queried in increasing order.
+    uint16_t keys_at(size_t frame) {
+        while (cursor < events.size() && events[cursor].frame <= frame) current = events[cursor++].keydown;
+        return current;
+    }
+
+    void rewind() {
+        cursor = 0;
+        current = 0;
+    }
+};
+
+#endif
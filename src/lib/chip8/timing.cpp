@@ -0,0 +1,148 @@
+#include "chip8.hpp"
+#include "../instructions/parser.hpp"
+
+// COSMAC VIP timing. The interpreter on the VIP spends a different number of machine
+// cycles on each instruction, and the 60 Hz display interrupt both decrements the timers
+// and steals VIP_DISPLAY_CYCLES of every frame for the display DMA. The costs below are
+// approximate figures for the original interpreter, rounded to machine cycles, and include
+// the fetch and dispatch every instruction goes through.
+#define VIP_FRAME_BUDGET (VIP_FRAME_CYCLES - VIP_DISPLAY_CYCLES) // Left to the interpreter
+#define VIP_SKIP_CYCLES 4      // Extra when a skip is taken
+#define VIP_ROW_CYCLES 14      // DXYN per sprite row, doubled when the row straddles two bytes
+#define VIP_REG_CYCLES 14      // FX55 and FX65 per register
+#define VIP_BCD_DIGIT_CYCLES 16 // FX33 per unit of each decimal digit, it counts by subtraction
+
+// Fixed part of every instruction, indexed by OpKind
+static const uint16_t vip_cycles[static_cast<size_t>(OpKind::Count)] = {
+    64,  // Cls
+    62,  // Ret
+    52,  // Jp
+    66,  // Call
+    50,  // Se
+    50,  // Sne
+    54,  // Sev
+    54,  // Snev
+    46,  // Ldv
+    50,  // Addv
+    84,  // Ldr
+    84,  // Or
+    84,  // And
+    84,  // Xor
+    84,  // AddR
+    84,  // Sub
+    84,  // Subn
+    84,  // Shr
+    84,  // Shl
+    52,  // Ldi
+    62,  // Jp0
+    76,  // Rnd
+    66,  // Drw
+    54,  // Skp
+    54,  // Sknp
+    50,  // LdDt
+    72,  // Key, per poll while it waits
+    50,  // StDt
+    50,  // StSt
+    58,  // AddI
+    60,  // LdF
+    64,  // Bcd
+    58,  // Str
+    58,  // LdRm
+    50,  // Audio, not a VIP instruction
+    50,  // Pitch, not a VIP instruction
+    62,  // Unknown, runs as 0NNN machine code on the VIP
+};
+
+bool parse_timing(const std::string& name, Timing& timing) {
+    if (name == "fixed") timing = Timing::Fixed;
+    else if (name == "vip") timing = Timing::Vip;
+    else return false;
+    return true;
+}
+
+const char* timing_name(Timing timing) {
+    switch (timing) {
+        case Timing::Fixed: return "fixed";
+        case Timing::Vip: return "vip";
+    }
+    return "unknown";
+}
+
+void Chip8::set_timing(Timing t) {
+    timing = t;
+    frame_cycles = 0;
+    held_key = -1;
+}
+
+// FX0A on the VIP waits for a key to go down and then up again; the key is stored and the
+// program moves on only when it is released
+void Chip8::wait_key_release(uint8_t x, uint16_t keydown) {
+    if (held_key < 0) {
+        for (int8_t key = 0; key < 16; ++key) {
+            if (keydown & (1 << key)) {
+                held_key = key;
+                break;
+            }
+        }
+        return;
+    }
+    if (keydown & (1 << held_key)) return;
+    V[x] = held_key;
+    held_key = -1;
+    pc += 2;
+}
+
+void Chip8::step_vip(uint16_t keydown) {
+    tick++;
+    const uint16_t at = pc;
+    const DecodedInst inst = engine == Engine::Predecoded
+        ? predecoded[pc & MEM_MASK]
+        : DecodedInst((memory[pc & MEM_MASK] << 8) | memory[(pc + 1) & MEM_MASK]);
+    uint32_t cost = vip_cycles[static_cast<size_t>(inst.kind)];
+
+    // Operand dependent costs, from the state before the instruction changes it
+    switch (inst.kind) {
+    case OpKind::Drw:
+        cost += inst.n() * VIP_ROW_CYCLES * (V[inst.x()] % 8 ? 2 : 1);
+        frame_cycles = VIP_FRAME_BUDGET; // Wait for the vertical blank, then draw
+        break;
+    case OpKind::Bcd: {
+        uint8_t value = V[inst.x()];
+        cost += (value / 100 + value / 10 % 10 + value % 10) * VIP_BCD_DIGIT_CYCLES;
+        break;
+    }
+    case OpKind::Str:
+    case OpKind::LdRm:
+        cost += (inst.x() + 1) * VIP_REG_CYCLES;
+        break;
+    default:
+        break;
+    }
+
+    if (inst.kind == OpKind::Key) {
+        wait_key_release(inst.x(), keydown);
+    } else {
+        pc += 2;
+        if (engine == Engine::Reference) Chip8Parser::parse(inst.opcode)->execute(*this, keydown);
+        else execute_switch(inst.opcode, inst.kind, keydown);
+        if (pc == static_cast<uint16_t>(at + 4)) {
+            switch (inst.kind) {
+            case OpKind::Se: case OpKind::Sne: case OpKind::Sev: case OpKind::Snev:
+            case OpKind::Skp: case OpKind::Sknp:
+                cost += VIP_SKIP_CYCLES;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    // The display interrupt at the end of the frame counts the timers down
+    frame_cycles += cost;
+    while (frame_cycles >= VIP_FRAME_BUDGET) {
+        frame_cycles -= VIP_FRAME_BUDGET;
+        vip_frames++;
+        if (delay > 0) --delay;
+        if (sound > 0) set_sound(sound - 1);
+    }
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include "console.hpp"
+#include "../instructions/decode.hpp"
+#include "../utils/format.hpp"
+
+static const char* const help_text =
+    "break ADDR [if REG OP VALUE]   stop before ADDR, optionally only when e.g. V3 == 0x10\n"
+    "                               REG: V0-VF, I, DT, ST, SP; OP: == != < <= > >=\n"
+    "watch ADDR[-END|+LEN] [r|w|rw] stop after an instruction reads or writes the bytes (default w)\n"
+    "delete [ID]                    remove one breakpoint or watchpoint, or all\n"
+    "info                           list breakpoints and watchpoints\n"
+    "regs                           registers, timers and stack\n"
+    "mem ADDR [LEN]                 hex dump\n"
+    "list [ADDR] [N]                disassemble N instructions from ADDR (default: pc)\n"
+    "step [N]                       execute N instructions\n"
+    "continue                       resume\n"
+    "quit                           stop the emulator\n";
+
+bool DebugConsole::number(const std::string& token, uint32_t& value, uint32_t max) {
+    size_t used = 0;
+    unsigned long v = 0;
+    try {
+        v = std::stoul(token, &used, 0);
+    } catch (const std::logic_error&) {
+        used = 0;
+    }
+    if (used == 0 || used != token.size() || v > max) {
+        out << "Invalid number: " << token << "\n";
+        return false;
+    }
+    value = static_cast<uint32_t>(v);
+    return true;
+}
+
+void DebugConsole::where(uint16_t addr) {
+    out << hex(addr, 4);
+    if (!source_map) return;
+    std::string line = source_map->describe(addr);
+    if (!line.empty()) out << " (" << line << ")";
+}
+
+void DebugConsole::report(const Stop& stop, const Chip8& chip8) {
+    switch (stop.reason) {
+    case StopReason::Breakpoint:
+        out << "Breakpoint " << stop.id << " at ";
+        where(stop.addr);
+        out << "\n";
+        break;
+    case StopReason::Watchpoint:
+        out << "Watchpoint " << stop.id << ": " << (stop.access == ACCESS_WRITE ? "write to " : "read of ")
+            << hex(stop.addr, 3) << " = " << hex(chip8.ram()[stop.addr], 2) << ", now at ";
+        where(chip8.program_counter());
+        out << "\n";
+        break;
+    case StopReason::Finished:
+        out << "Halted (" << halt_name(chip8.halt()) << ") at " << hex(chip8.program_counter(), 4) << "\n";
+        return;
+    case StopReason::Fault:
+        out << "Fault: " << chip8.fault_message() << "\n";
+        break;
+    case StopReason::Steps:
+        break;
+    }
+    list(chip8, chip8.program_counter(), 1);
+}
+
+void DebugConsole::registers(const Chip8& chip8) {
+    const uint8_t* V = chip8.registers();
+    for (int i = 0; i < N_REG; i++) {
+        out << register_name(i) << "=" << hex(V[i], 2) << (i % 8 == 7 ? "\n" : " ");
+    }
+    out << "I=" << hex(chip8.index(), 3) << " PC=" << hex(chip8.program_counter(), 4)
+        << " DT=" << static_cast<int>(chip8.delay_timer()) << " ST=" << static_cast<int>(chip8.sound_timer())
+        << " SP=" << static_cast<int>(chip8.stack_pointer()) << "\n";
+    for (int i = chip8.stack_pointer() - 1; i >= 0; i--) {
+        out << "  #" << i << " return to ";
+        where(chip8.call_stack()[i]);
+        out << "\n";
+    }
+}
+
+void DebugConsole::memory(const Chip8& chip8, uint16_t addr, uint32_t len) {
+    for (uint32_t row = 0; row < len; row += 16) {
+        out << hex((addr + row) & MEM_MASK, 3) << ":";
+        for (uint32_t i = row; i < len && i < row + 16; i++) out << " " << hex(chip8.ram()[(addr + i) & MEM_MASK], 2);
+        out << "\n";
+    }
+}
+
+void DebugConsole::list(const Chip8& chip8, uint16_t addr, uint32_t lines) {
+    const uint8_t* ram = chip8.ram();
+    for (uint32_t i = 0; i < lines; i++) {
+        const uint16_t at = (addr + i * 2) & MEM_MASK;
+        DecodedInst inst((ram[at] << 8) | ram[(at + 1) & MEM_MASK]);
+        out << (at == chip8.program_counter() ? " -> " : "    ") << hex(at, 4) << ": " << hex(inst.opcode, 4)
+            << "  " << inst.cmd() << " " << inst.arg();
+        if (source_map) {
+            std::string line = source_map->describe(at);
+            if (!line.empty()) out << "  ; " << line;
+        }
+        out << "\n";
+    }
+}
+
+void DebugConsole::points() {
+    if (!debugger.armed()) {
+        out << "No breakpoints or watchpoints\n";
+        return;
+    }
+    for (const Breakpoint& b : debugger.breakpoints()) {
+        out << b.id << ": break " << hex(b.addr, 4);
+        if (b.condition.active) {
+            out << " if " << register_name(b.condition.reg) << " " << compare_name(b.condition.op) << " "
+                << hex(b.condition.value, 2);
+        }
+        out << "\n";
+    }
+    for (const Watchpoint& w : debugger.watchpoints()) {
+        out << w.id << ": watch " << hex(w.first, 3) << "-" << hex(w.last, 3) << " "
+            << (w.access & ACCESS_READ ? "r" : "") << (w.access & ACCESS_WRITE ? "w" : "") << "\n";
+    }
+}
+
+void DebugConsole::step(Chip8& chip8, size_t n, uint16_t keydown) {
+    report(debugger.run(chip8, n, keydown), chip8);
+}
+
+void DebugConsole::add_breakpoint(const std::vector<std::string>& args) {
+    uint32_t addr, value;
+    Condition condition;
+    if (args.size() != 2 && args.size() != 6) {
+        out << "Usage: break ADDR [if REG OP VALUE]\n";
+        return;
+    }
+    if (!number(args[1], addr, MEM_MASK)) return;
+    if (args.size() == 6) {
+        if (args[2] != "if" || !parse_register(args[3], condition.reg) || !parse_compare(args[4], condition.op)) {
+            out << "Usage: break ADDR [if REG OP VALUE]\n";
+            return;
+        }
+        if (!number(args[5], value)) return;
+        condition.active = true;
+        condition.value = static_cast<uint16_t>(value);
+    }
+    out << "Breakpoint " << debugger.add_breakpoint(static_cast<uint16_t>(addr), condition) << " at ";
+    where(static_cast<uint16_t>(addr));
+    out << "\n";
+}
+
+void DebugConsole::add_watchpoint(const std::vector<std::string>& args) {
+    if (args.size() < 2 || args.size() > 3) {
+        out << "Usage: watch ADDR[-END|+LEN] [r|w|rw]\n";
+        return;
+    }
+    const std::string& range = args[1];
+    size_t sep = range.find_first_of("-+", 1);
+    uint32_t first, last;
+    if (!number(range.substr(0, sep), first, MEM_MASK)) return;
+    last = first;
+    if (sep != std::string::npos) {
+        uint32_t v;
+        if (!number(range.substr(sep + 1), v, range[sep] == '+' ? MEM_SIZE : MEM_MASK)) return;
+        if (range[sep] == '+') {
+            if (v == 0 || first + v > MEM_SIZE) {
+                out << "Invalid length: " << range << "\n";
+                return;
+            }
+            last = first + v - 1;
+        } else {
+            last = v;
+        }
+    }
+    uint8_t access = ACCESS_WRITE;
+    if (args.size() == 3) {
+        if (args[2] == "r") access = ACCESS_READ;
+        else if (args[2] == "w") access = ACCESS_WRITE;
+        else if (args[2] == "rw") access = ACCESS_READ | ACCESS_WRITE;
+        else {
+            out << "Access must be r, w or rw\n";
+            return;
+        }
+    }
+    int id = debugger.add_watchpoint(static_cast<uint16_t>(first), static_cast<uint16_t>(last), access);
+    out << "Watchpoint " << id << " on " << hex(std::min(first, last), 3) << "-" << hex(std::max(first, last), 3) << "\n";
+}
+
+bool DebugConsole::command(const std::string& line, Chip8& chip8, uint16_t keydown, bool& quit) {
+    std::istringstream fields(line);
+    std::vector<std::string> args;
+    for (std::string word; fields >> word;) args.push_back(word);
+    if (args.empty()) return true;
+
+    const std::string& cmd = args[0];
+    uint32_t a = 0, b = 0;
+    if (cmd == "c" || cmd == "continue") {
+        return false;
+    } else if (cmd == "q" || cmd == "quit") {
+        quit = true;
+        return false;
+    } else if (cmd == "b" || cmd == "break") {
+        add_breakpoint(args);
+    } else if (cmd == "w" || cmd == "watch") {
+        add_watchpoint(args);
+    } else if (cmd == "d" || cmd == "delete") {
+        if (args.size() == 1) {
+            debugger.clear();
+            out << "Deleted all breakpoints and watchpoints\n";
+        } else if (number(args[1], a) && !debugger.remove(static_cast<int>(a))) {
+            out << "No breakpoint or watchpoint " << a << "\n";
+        }
+    } else if (cmd == "i" || cmd == "info") {
+        points();
+    } else if (cmd == "r" || cmd == "regs") {
+        registers(chip8);
+    } else if (cmd == "x" || cmd == "mem") {
+        b = CONSOLE_DUMP_BYTES;
+        if (args.size() < 2 || !number(args[1], a, MEM_MASK)) {
+            if (args.size() < 2) out << "Usage: mem ADDR [LEN]\n";
+            return true;
+        }
+        if (args.size() > 2 && !number(args[2], b, MEM_SIZE)) return true;
+        memory(chip8, static_cast<uint16_t>(a), b);
+    } else if (cmd == "l" || cmd == "list") {
+        a = chip8.program_counter();
+        b = CONSOLE_LIST_LINES;
+        if (args.size() > 1 && !number(args[1], a, MEM_MASK)) return true;
+        if (args.size() > 2 && !number(args[2], b, MEM_SIZE / 2)) return true;
+        list(chip8, static_cast<uint16_t>(a), b);
+    } else if (cmd == "s" || cmd == "step") {
+        b = 1;
+        if (args.size() > 1 && !number(args[1], b, UINT32_MAX)) return true;
+        step(chip8, b, keydown);
+    } else if (cmd == "h" || cmd == "help") {
+        out << help_text;
+    } else {
+        out << "Unknown command: " << cmd << " (try help)\n";
+    }
+    return true;
+}
+
+bool DebugConsole::run(std::istream& in, Chip8& chip8, uint16_t keydown) {
+    bool quit = false;
+    std::string line;
+    for (;;) {
+        out << CONSOLE_PROMPT << std::flush;
+        if (!std::getline(in, line)) return false;
+        if (!command(line, chip8, keydown, quit)) return !quit;
+    }
+}
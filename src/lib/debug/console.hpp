@@ -0,0 +1,46 @@
+#ifndef SRC_LIB_DEBUG_CONSOLE_HPP
+#define SRC_LIB_DEBUG_CONSOLE_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "debugger.hpp"
+#include "../asm/source_map.hpp"
+
+#define CONSOLE_PROMPT "(chip8) "
+#define CONSOLE_DUMP_BYTES 64 // Default length of "mem"
+#define CONSOLE_LIST_LINES 8  // Default length of "list"
+
+// Line-oriented command console over a Debugger, for stopping points in the UI and in
+// headless runs. "help" lists the commands.
+class DebugConsole {
+private:
+    Debugger& debugger;
+    std::ostream& out;
+    const SourceMap* source_map = nullptr;
+
+    bool number(const std::string& token, uint32_t& value, uint32_t max = 0xFFFF);
+    void where(uint16_t addr);
+    void registers(const Chip8& chip8);
+    void memory(const Chip8& chip8, uint16_t addr, uint32_t len);
+    void list(const Chip8& chip8, uint16_t addr, uint32_t lines);
+    void points();
+    void step(Chip8& chip8, size_t n, uint16_t keydown);
+    void add_breakpoint(const std::vector<std::string>& args);
+    void add_watchpoint(const std::vector<std::string>& args);
+
+public:
+    explicit DebugConsole(Debugger& debugger, std::ostream& out = std::cerr): debugger(debugger), out(out) {}
+
+    // Source map from the assembler, used to show file:line next to addresses
+    void set_source_map(const SourceMap* map) { source_map = map; }
+
+    // Print why the machine stopped
+    void report(const Stop& stop, const Chip8& chip8);
+    // Runs one command. Returns false when execution should resume; `quit` is set by "quit".
+    bool command(const std::string& line, Chip8& chip8, uint16_t keydown, bool& quit);
+    // Reads commands until "continue" (returns true) or "quit" or end of input (false)
+    bool run(std::istream& in, Chip8& chip8, uint16_t keydown);
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cstring>
+#include "debugger.hpp"
+#include "../instructions/decode.hpp"
+
+static const char* const register_names[] = {
+    "V0", "V1", "V2", "V3", "V4", "V5", "V6", "V7", "V8", "V9", "VA", "VB", "VC", "VD", "VE", "VF",
+    "I", "DT", "ST", "SP",
+};
+
+const char* register_name(uint8_t reg) {
+    return reg <= REG_SP ? register_names[reg] : "?";
+}
+
+bool parse_register(const std::string& name, uint8_t& reg) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    for (uint8_t r = 0; r <= REG_SP; r++) {
+        if (upper == register_names[r]) {
+            reg = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+static const char* const compare_names[] = {"==", "!=", "<", "<=", ">", ">="};
+
+const char* compare_name(Compare op) {
+    return compare_names[static_cast<int>(op)];
+}
+
+bool parse_compare(const std::string& op, Compare& compare) {
+    for (int i = 0; i < 6; i++) {
+        if (op == compare_names[i]) {
+            compare = static_cast<Compare>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool compare(Compare op, uint16_t a, uint16_t b) {
+    switch (op) {
+    case Compare::Eq: return a == b;
+    case Compare::Ne: return a != b;
+    case Compare::Lt: return a < b;
+    case Compare::Le: return a <= b;
+    case Compare::Gt: return a > b;
+    case Compare::Ge: return a >= b;
+    }
+    return false;
+}
+
+bool Condition::holds(const Chip8& chip8) const {
+    if (!active) return true;
+    uint16_t v;
+    switch (reg) {
+    case REG_I: v = chip8.index(); break;
+    case REG_DT: v = chip8.delay_timer(); break;
+    case REG_ST: v = chip8.sound_timer(); break;
+    case REG_SP: v = chip8.stack_pointer(); break;
+    default: v = chip8.registers()[reg & 0xF]; break;
+    }
+    return compare(op, v, value);
+}
+
+int Debugger::add_breakpoint(uint16_t addr, const Condition& condition) {
+    breakpoints_.push_back({next_id, static_cast<uint16_t>(addr & MEM_MASK), condition});
+    rebuild_flags();
+    return next_id++;
+}
+
+int Debugger::add_watchpoint(uint16_t first, uint16_t last, uint8_t access) {
+    first &= MEM_MASK;
+    last &= MEM_MASK;
+    if (first > last) std::swap(first, last);
+    watchpoints_.push_back({next_id, first, last, access});
+    rebuild_flags();
+    return next_id++;
+}
+
+bool Debugger::remove(int id) {
+    auto has_id = [id](const auto& p) { return p.id == id; };
+    size_t before = breakpoints_.size() + watchpoints_.size();
+    breakpoints_.erase(std::remove_if(breakpoints_.begin(), breakpoints_.end(), has_id), breakpoints_.end());
+    watchpoints_.erase(std::remove_if(watchpoints_.begin(), watchpoints_.end(), has_id), watchpoints_.end());
+    rebuild_flags();
+    return breakpoints_.size() + watchpoints_.size() != before;
+}
+
+void Debugger::clear() {
+    breakpoints_.clear();
+    watchpoints_.clear();
+    rebuild_flags();
+}
+
+void Debugger::rebuild_flags() {
+    memset(flags, 0, sizeof(flags));
+    for (const Breakpoint& b : breakpoints_) flags[b.addr] |= F_BREAK;
+    for (const Watchpoint& w : watchpoints_) {
+        uint8_t f = ((w.access & ACCESS_READ) ? F_READ : 0) | ((w.access & ACCESS_WRITE) ? F_WRITE : 0);
+        for (uint32_t a = w.first; a <= w.last; a++) flags[a] |= f;
+    }
+}
+
+bool Debugger::hit_breakpoint(const Chip8& chip8, Stop& stop) const {
+    const uint16_t pc = chip8.program_counter() & MEM_MASK;
+    if (!(flags[pc] & F_BREAK)) return false;
+    for (const Breakpoint& b : breakpoints_) {
+        if (b.addr != pc || !b.condition.holds(chip8)) continue;
+        stop.reason = StopReason::Breakpoint;
+        stop.id = b.id;
+        stop.addr = pc;
+        return true;
+    }
+    return false;
+}
+
+// Checked before the instruction runs, while I still has the value it uses
+bool Debugger::touches_watched(const Chip8& chip8, Stop& stop) const {
+    if (watchpoints_.empty()) return false;
+    const uint8_t* ram = chip8.ram();
+    const uint16_t pc = chip8.program_counter();
+    DecodedInst inst((ram[pc & MEM_MASK] << 8) | ram[(pc + 1) & MEM_MASK]);
+    uint8_t access;
+    uint32_t count;
+    switch (inst.kind) {
+    case OpKind::Bcd: access = ACCESS_WRITE; count = 3; break;
+    case OpKind::Str: access = ACCESS_WRITE; count = inst.x() + 1u; break;
+    case OpKind::LdRm: access = ACCESS_READ; count = inst.x() + 1u; break;
+    case OpKind::Drw: access = ACCESS_READ; count = inst.n(); break;
+    case OpKind::Audio: access = ACCESS_READ; count = 16; break;
+    default: return false;
+    }
+    const uint8_t mask = access == ACCESS_WRITE ? F_WRITE : F_READ;
+    for (uint32_t k = 0; k < count; k++) {
+        const uint16_t addr = (chip8.index() + k) & MEM_MASK;
+        if (!(flags[addr] & mask)) continue;
+        for (const Watchpoint& w : watchpoints_) {
+            if (addr < w.first || addr > w.last || !(w.access & access)) continue;
+            stop.reason = StopReason::Watchpoint;
+            stop.id = w.id;
+            stop.addr = addr;
+            stop.access = access;
+            return true;
+        }
+    }
+    return false;
+}
+
+static StopReason finish_reason(const Chip8& chip8) {
+    if (chip8.fault() != Fault::None) return StopReason::Fault;
+    return chip8.finished() ? StopReason::Finished : StopReason::Steps;
+}
+
+Stop Debugger::run(Chip8& chip8, size_t n, uint16_t keydown) {
+    Stop stop;
+    if (!armed()) {
+        for (; stop.steps < n && !chip8.finished(); stop.steps++) chip8.step(keydown);
+        resume_from = -1;
+        stop.reason = finish_reason(chip8);
+        return stop;
+    }
+    for (; stop.steps < n && !chip8.finished(); stop.steps++) {
+        const uint16_t pc = chip8.program_counter();
+        if (pc != resume_from && hit_breakpoint(chip8, stop)) {
+            resume_from = pc;
+            return stop;
+        }
+        resume_from = -1;
+        Stop watch;
+        const bool watched = touches_watched(chip8, watch);
+        chip8.step(keydown);
+        if (watched) {
+            watch.steps = stop.steps + 1;
+            return watch;
+        }
+    }
+    stop.reason = finish_reason(chip8);
+    return stop;
+}
@@ -0,0 +1,112 @@
+#ifndef SRC_LIB_DEBUGGER_HPP
+#define SRC_LIB_DEBUGGER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "../chip8/chip8.hpp"
+
+// Register operand of a breakpoint condition: 0-15 are V0-VF
+enum DebugRegister : uint8_t {
+    REG_I = N_REG,
+    REG_DT,
+    REG_ST,
+    REG_SP,
+};
+
+enum class Compare : uint8_t { Eq, Ne, Lt, Le, Gt, Ge };
+
+bool compare(Compare op, uint16_t a, uint16_t b);
+
+// "V3 == 0x10"; an inactive condition always holds
+struct Condition {
+    bool active = false;
+    uint8_t reg = 0;
+    Compare op = Compare::Eq;
+    uint16_t value = 0;
+
+    bool holds(const Chip8& chip8) const;
+};
+
+// Memory access bits of a watchpoint
+enum Access : uint8_t {
+    ACCESS_READ = 1 << 0,  // Fx65, Dxyn and F002 reading the bytes
+    ACCESS_WRITE = 1 << 1, // Fx33 and Fx55 writing them
+};
+
+struct Breakpoint {
+    int id;
+    uint16_t addr;
+    Condition condition;
+};
+
+struct Watchpoint {
+    int id;
+    uint16_t first;
+    uint16_t last; // Inclusive
+    uint8_t access;
+};
+
+enum class StopReason : uint8_t {
+    Steps,      // Ran every instruction asked for
+    Finished,   // The machine halted; see Chip8::halt()
+    Fault,      // The machine faulted; see Chip8::fault()
+    Breakpoint, // Stopped before the instruction at a breakpoint
+    Watchpoint, // Stopped after an instruction that accessed a watched byte
+};
+
+struct Stop {
+    StopReason reason = StopReason::Steps;
+    size_t steps = 0; // Instructions executed
+    int id = 0;       // Breakpoint or watchpoint that fired
+    uint16_t addr = 0; // Breakpoint address, or the watched byte accessed
+    uint8_t access = 0;
+};
+
+// PC breakpoints, conditional on a register, and read/write watchpoints on memory ranges.
+// A flag per address says whether anything is set there, so a checked step costs one load
+// for the PC plus a few for the instructions that touch memory. With nothing set run()
+// is the plain step loop.
+class Debugger {
+private:
+    enum : uint8_t {
+        F_BREAK = 1 << 0,
+        F_READ = 1 << 1,
+        F_WRITE = 1 << 2,
+    };
+
+    uint8_t flags[MEM_SIZE]{};
+    std::vector<Breakpoint> breakpoints_;
+    std::vector<Watchpoint> watchpoints_;
+    int next_id = 1;
+    int resume_from = -1; // PC of the breakpoint just stopped at, not hit again on resume
+
+    void rebuild_flags();
+    bool hit_breakpoint(const Chip8& chip8, Stop& stop) const;
+    bool touches_watched(const Chip8& chip8, Stop& stop) const;
+
+public:
+    int add_breakpoint(uint16_t addr, const Condition& condition = {});
+    int add_watchpoint(uint16_t first, uint16_t last, uint8_t access);
+    bool remove(int id);
+    void clear();
+    bool armed() const { return !breakpoints_.empty() || !watchpoints_.empty(); }
+
+    const std::vector<Breakpoint>& breakpoints() const { return breakpoints_; }
+    const std::vector<Watchpoint>& watchpoints() const { return watchpoints_; }
+
+    // Resume from a breakpoint at `pc` without stopping there again straight away
+    void resume_at(uint16_t pc) { resume_from = pc; }
+
+    // Step up to `n` instructions. Stops early at a breakpoint, a watchpoint or the end of
+    // the program. A fault halts the machine and stops the run with StopReason::Fault.
+    Stop run(Chip8& chip8, size_t n, uint16_t keydown);
+};
+
+const char* register_name(uint8_t reg);
+bool parse_register(const std::string& name, uint8_t& reg);
+bool parse_compare(const std::string& op, Compare& compare);
+const char* compare_name(Compare op);
+
+#endif
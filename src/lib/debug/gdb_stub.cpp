@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "gdb_stub.hpp"
+#include "../utils/format.hpp"
+
+#define GDB_SIGINT "02"  // Stopped by Ctrl-C
+#define GDB_SIGTRAP "05" // Breakpoint, watchpoint or step
+#define GDB_SIGSEGV "0b" // Stack fault
+
+static const char target_xml[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+    "<target version=\"1.0\">\n"
+    "  <feature name=\"org.chip8.core\">\n"
+    "    <reg name=\"v0\" bitsize=\"8\" type=\"uint8\" regnum=\"0\"/>\n"
+    "    <reg name=\"v1\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"v2\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"v3\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"v4\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"v5\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"v6\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"v7\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"v8\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"v9\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"va\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"vb\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"vc\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"vd\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"ve\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"vf\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"i\" bitsize=\"16\" type=\"data_ptr\"/>\n"
+    "    <reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/>\n"
+    "    <reg name=\"sp\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"dt\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"st\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "  </feature>\n"
+    "</target>\n";
+
+static void put_hex_byte(std::string& out, uint8_t b) {
+    static const char digits[] = "0123456789abcdef";
+    out.push_back(digits[b >> 4]);
+    out.push_back(digits[b & 0xF]);
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parses hex digits up to the end or a character in `stop`; false if there are none
+static bool parse_hex(const std::string& s, size_t& pos, uint32_t& value, const char* stop = ",:;#") {
+    size_t start = pos;
+    value = 0;
+    while (pos < s.size() && !strchr(stop, s[pos])) {
+        int d = hex_digit(s[pos]);
+        if (d < 0 || value > 0x0FFFFFFF) return false;
+        value = (value << 4) | d;
+        pos++;
+    }
+    return pos > start;
+}
+
+GdbStub::GdbStub(Chip8& chip8, uint16_t port, uint16_t keydown): chip8(chip8), keydown(keydown) {
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) throw std::runtime_error("Failed to create socket");
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Never reachable from outside the host
+    addr.sin_port = htons(port);
+    socklen_t len = sizeof(addr);
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 1) < 0 ||
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        close(listen_fd);
+        throw std::runtime_error("Failed to listen on 127.0.0.1:" + std::to_string(port));
+    }
+    port_ = ntohs(addr.sin_port);
+}
+
+GdbStub::GdbStub(Chip8& chip8, const std::string& path, uint16_t keydown): chip8(chip8), keydown(keydown) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) throw std::runtime_error("Socket path too long: " + path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) throw std::runtime_error("Failed to create socket");
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str()); // A stale socket from an earlier run
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 1) < 0) {
+        close(listen_fd);
+        throw std::runtime_error("Failed to listen on " + path);
+    }
+    socket_path = path;
+}
+
+GdbStub::~GdbStub() {
+    if (client_fd >= 0) close(client_fd);
+    if (listen_fd >= 0) close(listen_fd);
+    if (!socket_path.empty()) unlink(socket_path.c_str());
+}
+
+// Runner thread: executes while the stub says so and reports back how it stopped
+void GdbStub::run_target() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [&] { return state != State::Halted; });
+        if (state == State::Quit) return;
+        const bool step = state == State::Stepping;
+        lock.unlock();
+        Stop stop;
+        if (step) {
+            stop = debugger.run(chip8, 1, keydown);
+        } else {
+            do {
+                stop = debugger.run(chip8, GDB_RUN_CHUNK, keydown);
+            } while (stop.reason == StopReason::Steps && !interrupt);
+        }
+        lock.lock();
+        if (state == State::Quit) return;
+        last_stop = stop;
+        state = State::Halted;
+    }
+}
+
+void GdbStub::resume(State how) {
+    debugger.resume_at(chip8.program_counter());
+    interrupt = false;
+    std::lock_guard<std::mutex> lock(mutex);
+    state = how;
+    changed.notify_all();
+}
+
+void GdbStub::send(const std::string& payload) {
+    std::string packet = "$";
+    uint8_t sum = 0;
+    for (char c : payload) {
+        if (c == '$' || c == '#' || c == '}' || c == '*') {
+            packet.push_back('}');
+            sum += '}';
+            c ^= 0x20;
+        }
+        packet.push_back(c);
+        sum += static_cast<uint8_t>(c);
+    }
+    packet.push_back('#');
+    put_hex_byte(packet, sum);
+    for (size_t done = 0; done < packet.size();) {
+        ssize_t n = write(client_fd, packet.data() + done, packet.size() - done);
+        if (n <= 0) return; // The read side notices the disconnect
+        done += n;
+    }
+}
+
+std::string GdbStub::stop_reply() {
+    std::string reply = "T" GDB_SIGTRAP;
+    switch (last_stop.reason) {
+    case StopReason::Finished:
+        return "W00";
+    case StopReason::Fault:
+        return "T" GDB_SIGSEGV;
+    case StopReason::Steps:
+        return interrupt ? "T" GDB_SIGINT : reply;
+    case StopReason::Breakpoint:
+        return reply + (point_types[last_stop.id] == '1' ? "hwbreak:;" : "swbreak:;");
+    case StopReason::Watchpoint: {
+        char type = point_types[last_stop.id];
+        reply += type == '3' ? "rwatch:" : type == '4' ? "awatch:" : "watch:";
+        TextBuffer addr;
+        addr.put_hex(last_stop.addr, 0, false);
+        return reply + std::string(addr.view()) + ";";
+    }
+    }
+    return reply;
+}
+
+std::string GdbStub::read_registers() {
+    std::string out;
+    for (int i = 0; i < N_REG; i++) put_hex_byte(out, chip8.registers()[i]);
+    put_hex_byte(out, chip8.index() & 0xFF);
+    put_hex_byte(out, chip8.index() >> 8);
+    put_hex_byte(out, chip8.program_counter() & 0xFF);
+    put_hex_byte(out, chip8.program_counter() >> 8);
+    put_hex_byte(out, chip8.stack_pointer());
+    put_hex_byte(out, chip8.delay_timer());
+    put_hex_byte(out, chip8.sound_timer());
+    return out;
+}
+
+std::string GdbStub::read_memory(const std::string& args) {
+    size_t pos = 0;
+    uint32_t addr, len;
+    if (!parse_hex(args, pos, addr) || pos >= args.size() || args[pos++] != ',' || !parse_hex(args, pos, len)) return "E01";
+    if (addr >= MEM_SIZE) return "E01";
+    len = std::min<uint32_t>({len, MEM_SIZE - addr, (GDB_PACKET_SIZE - 4) / 2}); // Partial reads are allowed
+    std::string out;
+    for (uint32_t i = 0; i < len; i++) put_hex_byte(out, chip8.ram()[addr + i]);
+    return out;
+}
+
+std::string GdbStub::write_memory(const std::string& args) {
+    size_t pos = 0;
+    uint32_t addr, len;
+    if (!parse_hex(args, pos, addr) || pos >= args.size() || args[pos++] != ',' || !parse_hex(args, pos, len) ||
+        pos >= args.size() || args[pos++] != ':' || args.size() - pos != len * 2) {
+        return "E01";
+    }
+    if (addr + len > MEM_SIZE) return "E01";
+    for (uint32_t i = 0; i < len; i++) {
+        int hi = hex_digit(args[pos + i * 2]), lo = hex_digit(args[pos + i * 2 + 1]);
+        if (hi < 0 || lo < 0) return "E01";
+        chip8.poke(static_cast<uint16_t>(addr + i), static_cast<uint8_t>(hi << 4 | lo));
+    }
+    return "OK";
+}
+
+// Z/z type,addr,kind. Types 0/1 are breakpoints, 2/3/4 write/read/access watchpoints
+// over `kind` bytes.
+std::string GdbStub::set_point(const std::string& args, bool insert) {
+    size_t pos = 2;
+    uint32_t addr, kind;
+    const char type = args[0];
+    if (args.size() < 2 || type < '0' || type > '4' || args[1] != ',' || !parse_hex(args, pos, addr) ||
+        pos >= args.size() || args[pos++] != ',' || !parse_hex(args, pos, kind)) {
+        return "E01";
+    }
+    if (addr >= MEM_SIZE) return "E01";
+    const std::string key = args.substr(0, pos);
+    auto it = point_ids.find(key);
+    if (!insert) {
+        if (it != point_ids.end()) {
+            debugger.remove(it->second);
+            point_types.erase(it->second);
+            point_ids.erase(it);
+        }
+        return "OK";
+    }
+    if (it != point_ids.end()) return "OK";
+    int id;
+    if (type == '0' || type == '1') {
+        id = debugger.add_breakpoint(static_cast<uint16_t>(addr));
+    } else {
+        if (kind == 0 || addr + kind > MEM_SIZE) return "E01";
+        uint8_t access = type == '2' ? ACCESS_WRITE : type == '3' ? ACCESS_READ : ACCESS_READ | ACCESS_WRITE;
+        id = debugger.add_watchpoint(static_cast<uint16_t>(addr), static_cast<uint16_t>(addr + kind - 1), access);
+    }
+    point_ids[key] = id;
+    point_types[id] = type;
+    return "OK";
+}
+
+std::string GdbStub::query(const std::string& packet) {
+    if (packet.compare(0, 10, "qSupported") == 0) {
+        TextBuffer size;
+        size.put_hex(GDB_PACKET_SIZE, 0, false);
+        return "PacketSize=" + std::string(size.view()) + ";qXfer:features:read+;swbreak+;hwbreak+;QStartNoAckMode+";
+    }
+    const std::string xfer = "qXfer:features:read:target.xml:";
+    if (packet.compare(0, xfer.size(), xfer) == 0) {
+        size_t pos = xfer.size();
+        uint32_t offset, len;
+        if (!parse_hex(packet, pos, offset) || pos >= packet.size() || packet[pos++] != ',' || !parse_hex(packet, pos, len)) {
+            return "E01";
+        }
+        const size_t total = sizeof(target_xml) - 1;
+        if (offset >= total) return "l";
+        std::string chunk(target_xml + offset, std::min<size_t>(len, total - offset));
+        return (offset + chunk.size() < total ? "m" : "l") + chunk;
+    }
+    if (packet == "qAttached") return "1";
+    if (packet == "qC") return "QC1";
+    if (packet == "qfThreadInfo") return "m1";
+    if (packet == "qsThreadInfo") return "l";
+    if (packet == "qSymbol::") return "OK";
+    return "";
+}
+
+std::string GdbStub::handle(const std::string& packet) {
+    if (packet.empty()) return "";
+    switch (packet[0]) {
+    case '?':
+        return stop_reply();
+    case 'g':
+        return read_registers();
+    case 'p': {
+        size_t pos = 1;
+        uint32_t n;
+        if (!parse_hex(packet, pos, n) || n > 20) return "E01";
+        // Offset of register n in the 'g' layout: 16 one-byte V registers, then I and pc of two
+        static const uint8_t offset[21] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 18, 20, 21, 22};
+        const uint8_t size = (n == 16 || n == 17) ? 2 : 1;
+        return read_registers().substr(offset[n] * 2, size * 2);
+    }
+    case 'm':
+        return read_memory(packet.substr(1));
+    case 'M':
+        return write_memory(packet.substr(1));
+    case 'c':
+        resume(State::Running);
+        return "";
+    case 's':
+        resume(State::Stepping);
+        return "";
+    case 'Z':
+        return set_point(packet.substr(1), true);
+    case 'z':
+        return set_point(packet.substr(1), false);
+    case 'H':
+    case 'T':
+        return "OK";
+    case 'D':
+        detached = true;
+        return "OK";
+    case 'k':
+        detached = true;
+        return "";
+    case 'q':
+        return query(packet);
+    case 'Q':
+        if (packet == "QStartNoAckMode") {
+            ack = false; // This packet itself was still acknowledged
+            return "OK";
+        }
+        return "";
+    case 'v':
+        if (packet.compare(0, 5, "vKill") == 0) {
+            detached = true;
+            return "OK";
+        }
+        return "";
+    default:
+        return ""; // Unsupported packets get an empty reply
+    }
+}
+
+bool GdbStub::receive(int timeout_ms) {
+    pollfd p{client_fd, POLLIN, 0};
+    int ready = poll(&p, 1, timeout_ms);
+    if (ready <= 0) return ready == 0;
+    char buf[4096];
+    ssize_t n = read(client_fd, buf, sizeof(buf));
+    if (n <= 0) return false;
+    input.append(buf, n);
+    return true;
+}
+
+void GdbStub::serve() {
+    client_fd = accept(listen_fd, nullptr, nullptr);
+    if (client_fd < 0) throw std::runtime_error("Failed to accept a debugger connection");
+    if (socket_path.empty()) {
+        int one = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    std::thread runner(&GdbStub::run_target, this);
+
+    bool connected = true;
+    bool waiting = false; // For the runner to stop, after c or s
+    while (connected && !detached) {
+        if (waiting) {
+            connected = receive(GDB_POLL_MS);
+            auto ctrl_c = std::remove(input.begin(), input.end(), '\x03');
+            if (ctrl_c != input.end()) {
+                input.erase(ctrl_c, input.end());
+                interrupt = true;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            if (state != State::Halted) continue;
+            lock.unlock();
+            waiting = false;
+            send(stop_reply());
+            continue;
+        }
+
+        // Halted: handle every complete packet, then wait for more
+        size_t start = input.find('$');
+        size_t hash = start == std::string::npos ? start : input.find('#', start);
+        if (hash == std::string::npos || hash + 2 >= input.size()) {
+            connected = receive(-1);
+            continue;
+        }
+        std::string payload = input.substr(start + 1, hash - start - 1);
+        int hi = hex_digit(input[hash + 1]), lo = hex_digit(input[hash + 2]);
+        input.erase(0, hash + 3); // Also drops acks and Ctrl-C sent while halted
+        uint8_t sum = 0;
+        for (char c : payload) sum += static_cast<uint8_t>(c);
+        if (hi < 0 || lo < 0 || sum != (hi << 4 | lo)) {
+            if (ack && write(client_fd, "-", 1) < 0) connected = false;
+            continue;
+        }
+        if (ack && write(client_fd, "+", 1) < 0) connected = false;
+        std::string reply = handle(payload);
+        const char cmd = payload.empty() ? 0 : payload[0];
+        if (cmd == 'c' || cmd == 's') waiting = true; // Replied to when the target stops
+        else if (cmd != 'k') send(reply);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        state = State::Quit;
+        interrupt = true;
+        changed.notify_all();
+    }
+    runner.join();
+    close(client_fd);
+    client_fd = -1;
+}
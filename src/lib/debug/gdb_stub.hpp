@@ -0,0 +1,79 @@
+#ifndef SRC_LIB_GDB_STUB_HPP
+#define SRC_LIB_GDB_STUB_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "debugger.hpp"
+
+#define GDB_PACKET_SIZE 0x4000 // Largest packet accepted, advertised in qSupported
+#define GDB_RUN_CHUNK 4096     // Instructions between checks for an interrupt while running
+#define GDB_POLL_MS 5          // How often a running target is checked for a stop
+
+// GDB remote serial protocol server for one Chip8, on 127.0.0.1 or a Unix socket.
+//
+// Registers, in 'g' packet order and as described by the target.xml it serves:
+//   v0..vf (8 bits), i (16), pc (16), sp (8), dt (8), st (8)
+// 16-bit registers are sent little-endian. Memory is the 4 KB address space.
+// Supports step, continue, Ctrl-C, memory read/write, software and hardware breakpoints
+// (Z0/Z1) and write/read/access watchpoints (Z2/Z3/Z4). The machine runs on its own
+// thread at full speed while the stub waits on the socket; register writes are not
+// supported.
+class GdbStub {
+private:
+    enum class State { Halted, Running, Stepping, Quit };
+
+    Chip8& chip8;
+    Debugger debugger;
+    uint16_t keydown;
+    int listen_fd = -1;
+    int client_fd = -1;
+    uint16_t port_ = 0;
+    std::string socket_path;
+
+    // Shared with the runner thread; the machine is only touched by the stub while Halted
+    std::mutex mutex;
+    std::condition_variable changed;
+    State state = State::Halted;
+    std::atomic<bool> interrupt{false};
+    Stop last_stop;
+
+    std::string input;    // Received bytes not yet handled
+    bool ack = true;      // Until QStartNoAckMode
+    bool detached = false;
+    std::map<int, char> point_types; // Debugger id -> Z packet type
+    std::map<std::string, int> point_ids; // "type,addr,kind" -> Debugger id
+
+    void run_target();
+    void resume(State how);
+    void send(const std::string& payload);
+    std::string stop_reply();
+    std::string handle(const std::string& packet);
+    std::string read_registers();
+    std::string read_memory(const std::string& args);
+    std::string write_memory(const std::string& args);
+    std::string set_point(const std::string& args, bool insert);
+    std::string query(const std::string& packet);
+    bool receive(int timeout_ms);
+
+public:
+    // Listen on 127.0.0.1:port; port 0 picks a free one. Throws std::runtime_error.
+    GdbStub(Chip8& chip8, uint16_t port, uint16_t keydown = 0);
+    // Listen on a Unix domain socket at `path`. Throws std::runtime_error.
+    GdbStub(Chip8& chip8, const std::string& path, uint16_t keydown = 0);
+    ~GdbStub();
+
+    GdbStub(const GdbStub&) = delete;
+    GdbStub& operator=(const GdbStub&) = delete;
+
+    uint16_t port() const { return port_; }
+
+    // Accept one client and serve it until it detaches, kills the target or disconnects
+    void serve();
+};
+
+#endif
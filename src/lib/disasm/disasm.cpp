@@ -0,0 +1,290 @@
+#include <algorithm>
+#include "disasm.hpp"
+#include "../instructions/decode.hpp"
+#include "../utils/format.hpp"
+
+Flow flow_of(uint16_t op) {
+    switch (decode(op)) {
+    case OpKind::Ret: return Flow::Return;
+    case OpKind::Jp: return Flow::Jump;
+    case OpKind::Call: return Flow::Call;
+    case OpKind::Se:
+    case OpKind::Sne:
+    case OpKind::Sev:
+    case OpKind::Snev:
+    case OpKind::Skp:
+    case OpKind::Sknp: return Flow::Skip;
+    case OpKind::Jp0: return Flow::Computed;
+    case OpKind::Unknown: return Flow::Invalid;
+    default: return Flow::Next;
+    }
+}
+
+static std::string addr_hex(uint32_t addr) {
+    TextBuffer out;
+    out.put_hex(addr, 4, false);
+    return std::string(out.view());
+}
+
+Disassembly::Disassembly(const uint8_t* data, size_t size, uint32_t origin)
+    : image(data), origin(origin), flags(DISASM_SPACE + 1), table_of(DISASM_SPACE, -1) {
+    limit = static_cast<uint32_t>(std::min<size_t>(origin + size, DISASM_SPACE));
+    explore();
+    build_blocks();
+    assign_functions();
+}
+
+void Disassembly::explore() {
+    auto mark = [&](uint32_t addr, uint8_t f) { if (addr < DISASM_SPACE) flags[addr] |= f; };
+    std::vector<uint32_t> work;
+    auto follow = [&](uint32_t addr, uint8_t f) {
+        mark(addr, f | F_LEADER);
+        if (in_image(addr)) work.push_back(addr);
+    };
+    follow(origin, F_FUNC);
+
+    while (!work.empty()) {
+        uint32_t a = work.back();
+        work.pop_back();
+        while (in_image(a) && !(flags[a] & F_CODE)) {
+            uint16_t op = word(a);
+            Flow flow = flow_of(op);
+            if (flow == Flow::Invalid) break;
+            if ((flags[a] & F_COVER) || (flags[a + 1] & F_CODE)) n_overlaps++;
+            flags[a] |= F_CODE | F_COVER;
+            flags[a + 1] |= F_COVER;
+            n_instructions++;
+
+            const uint32_t nnn = op & 0x0FFF;
+            if ((op >> 12) == 0xA) mark(nnn, F_DATA);
+            if (flow == Flow::Jump) {
+                if (nnn == a) {
+                    mark(a, F_TARGET | F_LEADER); // Halt loop, a block of its own
+                    break;
+                }
+                follow(nnn, F_TARGET);
+                break;
+            }
+            if (flow == Flow::Return) break;
+            if (flow == Flow::Call) {
+                follow(nnn, F_FUNC);
+                mark(a + 2, F_LEADER);
+            } else if (flow == Flow::Skip) {
+                mark(a + 2, F_LEADER);
+                follow(a + 4, F_TARGET);
+            } else if (flow == Flow::Computed) {
+                // JP0 nnn usually indexes a table of jumps; without V0 follow each entry
+                std::vector<uint32_t> table;
+                for (uint32_t e = nnn; table.size() < DISASM_MAX_TABLE && in_image(e); e += 2) {
+                    if (flow_of(word(e)) != Flow::Jump) break;
+                    table.push_back(e);
+                }
+                if (table.empty()) table.push_back(nnn); // V0 == 0 is all that is known
+                for (uint32_t t : table) follow(t, F_TARGET);
+                table_of[a] = static_cast<int32_t>(tables.size());
+                tables.push_back(std::move(table));
+                break;
+            }
+            a += 2;
+        }
+    }
+}
+
+void Disassembly::successors(uint32_t addr, Flow flow, std::vector<uint32_t>& out) const {
+    const uint32_t nnn = word(addr) & 0x0FFF;
+    auto add = [&](uint32_t t) { if (t < DISASM_SPACE && (flags[t] & F_CODE)) out.push_back(t); };
+    switch (flow) {
+    case Flow::Next:
+    case Flow::Call: add(addr + 2); break;
+    case Flow::Skip: add(addr + 2); add(addr + 4); break;
+    case Flow::Jump:
+    case Flow::Halt: add(nnn); break;
+    case Flow::Computed:
+        for (uint32_t t : tables[table_of[addr]]) add(t);
+        break;
+    case Flow::Return:
+    case Flow::Invalid: break;
+    }
+}
+
+void Disassembly::build_blocks() {
+    std::vector<bool> placed(DISASM_SPACE);
+    for (uint32_t a = origin; a < limit; a++) {
+        if (!(flags[a] & F_CODE) || placed[a]) continue;
+        BasicBlock block;
+        block.start = a;
+        uint32_t at = a;
+        for (;;) {
+            placed[at] = true;
+            Flow flow = flow_of(word(at));
+            uint32_t next = at + 2;
+            bool falls = flow == Flow::Next && next < limit && (flags[next] & F_CODE) && !(flags[next] & F_LEADER);
+            if (!falls) {
+                if (flow == Flow::Jump && (word(at) & 0x0FFF) == at) flow = Flow::Halt;
+                block.exit = flow;
+                break;
+            }
+            at = next;
+        }
+        block.end = at + 2;
+        block.function = UINT32_MAX;
+        if (block.exit == Flow::Call) block.call = word(at) & 0x0FFF;
+        successors(at, block.exit, block.successors);
+        blocks_.push_back(std::move(block));
+    }
+}
+
+void Disassembly::assign_functions() {
+    for (uint32_t a = origin; a < limit; a++) {
+        if ((flags[a] & F_FUNC) && (flags[a] & F_CODE)) functions_.push_back(a);
+    }
+    auto find = [&](uint32_t start) {
+        auto it = std::lower_bound(blocks_.begin(), blocks_.end(), start,
+            [](const BasicBlock& b, uint32_t s) { return b.start < s; });
+        return (it != blocks_.end() && it->start == start) ? &*it : nullptr;
+    };
+    // Blocks shared by several functions belong to the first one that reaches them
+    std::vector<BasicBlock*> work;
+    for (uint32_t entry : functions_) {
+        BasicBlock* first = find(entry);
+        if (!first || first->function != UINT32_MAX) continue;
+        first->function = entry;
+        work.push_back(first);
+        while (!work.empty()) {
+            BasicBlock* b = work.back();
+            work.pop_back();
+            for (uint32_t s : b->successors) {
+                BasicBlock* next = find(s);
+                if (next && next->function == UINT32_MAX) {
+                    next->function = entry;
+                    work.push_back(next);
+                }
+            }
+        }
+    }
+    // Blocks only reached through overlapping decodes go to the preceding function
+    uint32_t owner = origin;
+    for (BasicBlock& b : blocks_) {
+        if (b.function == UINT32_MAX) b.function = owner;
+        else owner = b.function;
+    }
+}
+
+size_t Disassembly::code_bytes() const {
+    size_t n = 0;
+    for (uint32_t a = origin; a < limit; a++) n += (flags[a] & F_COVER) != 0;
+    return n;
+}
+
+bool Disassembly::write_label(TextBuffer& out, uint32_t addr) const {
+    if (addr >= DISASM_SPACE) return false;
+    uint8_t f = flags[addr];
+    if (f & F_CODE) {
+        if ((f & F_FUNC) && addr == origin) out.put("main");
+        else if (f & F_FUNC) out.put("sub_").put_hex(addr, 4, false);
+        else if (f & F_TARGET) out.put("L_").put_hex(addr, 4, false);
+        else return false;
+        return true;
+    }
+    if ((f & F_DATA) && in_image(addr, 1)) {
+        out.put("data_").put_hex(addr, 4, false);
+        return true;
+    }
+    return false;
+}
+
+std::string Disassembly::label(uint32_t addr) const {
+    TextBuffer out;
+    write_label(out, addr);
+    return std::string(out.view());
+}
+
+void Disassembly::write_listing(std::ostream& out) const {
+    TextBuffer buf;
+    write_listing(buf, out);
+}
+
+void Disassembly::write_listing(TextBuffer& buf, std::ostream& out) const {
+    buf.put("; ").put_dec(n_instructions).put(" instructions, ").put_dec(functions_.size()).put(" functions, ")
+       .put_dec(blocks_.size()).put(" blocks, ").put_dec(code_bytes()).put(" of ").put_dec(limit - origin)
+       .put(" bytes are code");
+    if (n_overlaps) buf.put(", ").put_dec(n_overlaps).put(" overlapping");
+    buf.put('\n');
+
+    for (uint32_t a = origin; a < limit;) {
+        if (buf.size() >= LISTING_FLUSH_SIZE) buf.flush(out);
+        uint8_t f = flags[a];
+        if (f & F_CODE) {
+            if (f & F_FUNC) {
+                buf.put("\n; ---- function ");
+                write_label(buf, a);
+                buf.put(" ----\n");
+            } else if (f & F_LEADER) {
+                buf.put('\n');
+            }
+            if (write_label(buf, a)) buf.put(":\n");
+            uint16_t op = word(a);
+            DecodedInst inst(op);
+            buf.put("    ").put_hex(a, 4).put(": ").put_hex(op, 4, false).put("  ").put(inst.cmd()).put(' ');
+            inst.write_arg(buf);
+            uint8_t hi = op >> 12;
+            if (hi == 0x1 || hi == 0x2 || hi == 0xA || hi == 0xB) {
+                size_t mark = buf.size();
+                buf.put("  ; ");
+                if (!write_label(buf, op & 0x0FFF)) buf.truncate(mark);
+            }
+            if (flow_of(op) == Flow::Jump && (op & 0x0FFF) == a) buf.put("  ; halt");
+            buf.put('\n');
+            a += (flags[a + 1] & F_CODE) ? 1 : 2; // An overlapping instruction starts at a + 1
+            continue;
+        }
+        if (f & F_COVER) {
+            a++;
+            continue;
+        }
+        // Data run, at most 8 bytes per line, broken at labels and code
+        if (write_label(buf, a)) buf.put(":\n");
+        buf.put("    ").put_hex(a, 4).put(": DB ");
+        uint32_t n = 0;
+        do {
+            if (n) buf.put(", ");
+            buf.put_hex(image[a - origin], 2);
+            a++;
+            n++;
+        } while (n < 8 && a < limit && !(flags[a] & F_COVER) && !(flags[a] & F_DATA));
+        buf.put('\n');
+    }
+    buf.flush(out);
+}
+
+void Disassembly::write_dot(std::ostream& out, const std::string& name) const {
+    out << "digraph \"" << name << "\" {\n"
+        << "    node [shape=box fontname=\"monospace\"];\n";
+    for (uint32_t entry : functions_) {
+        out << "    subgraph cluster_" << addr_hex(entry) << " {\n"
+            << "        label=\"" << label(entry) << "\";\n";
+        for (const BasicBlock& b : blocks_) {
+            if (b.function != entry) continue;
+            out << "        b" << addr_hex(b.start) << " [label=\"";
+            std::string name = label(b.start);
+            if (!name.empty()) out << name << ":\\l";
+            for (uint32_t a = b.start; a < b.end; a += 2) {
+                DecodedInst inst(word(a));
+                out << addr_hex(a) << "  " << inst.cmd() << " " << inst.arg() << "\\l";
+            }
+            out << "\"];\n";
+        }
+        out << "    }\n";
+    }
+    for (const BasicBlock& b : blocks_) {
+        for (size_t i = 0; i < b.successors.size(); i++) {
+            out << "    b" << addr_hex(b.start) << " -> b" << addr_hex(b.successors[i]);
+            if (b.exit == Flow::Skip) out << (i == 0 ? " [label=\"no\"]" : " [label=\"skip\"]");
+            out << ";\n";
+        }
+        if (b.exit == Flow::Call && b.call < DISASM_SPACE && (flags[b.call] & F_CODE)) {
+            out << "    b" << addr_hex(b.start) << " -> b" << addr_hex(b.call) << " [style=dashed];\n";
+        }
+    }
+    out << "}\n";
+}
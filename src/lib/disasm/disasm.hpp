@@ -0,0 +1,93 @@
+#ifndef SRC_LIB_DISASM_HPP
+#define SRC_LIB_DISASM_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../utils/format.hpp"
+
+#define DISASM_SPACE 0x10000 // Largest address space handled, enough for XO-CHIP images
+#define DISASM_MAX_TABLE 64  // Entries followed in a JP0 jump table
+
+// How an instruction passes control on
+enum class Flow : uint8_t {
+    Next,     // Falls through
+    Jump,     // JP nnn
+    Call,     // CALL nnn, then falls through
+    Skip,     // Falls through or skips the next instruction
+    Return,   // RET
+    Halt,     // JP to itself, the usual way to end a program
+    Computed, // JP0 nnn, targets come from the jump table at nnn
+    Invalid,  // Not a known instruction; treated as the end of a code path
+};
+
+struct BasicBlock {
+    uint32_t start;
+    uint32_t end; // One past the last byte of the last instruction
+    uint32_t function; // Entry address of the owning function
+    Flow exit;
+    std::vector<uint32_t> successors; // Intra-procedural edges
+    uint32_t call = 0; // Call target when exit is Flow::Call
+};
+
+// Recursive-descent disassembly: follows control flow from the entry point instead of
+// decoding every word, so data is kept apart from code and odd-aligned code is found.
+class Disassembly {
+private:
+    enum : uint8_t {
+        F_CODE = 1 << 0,   // First byte of a decoded instruction
+        F_COVER = 1 << 1,  // Any byte of a decoded instruction
+        F_LEADER = 1 << 2, // Starts a basic block
+        F_FUNC = 1 << 3,   // Call target or entry point
+        F_TARGET = 1 << 4, // Jump or skip target
+        F_DATA = 1 << 5,   // Referenced through LDI
+    };
+
+    const uint8_t* image;
+    uint32_t origin;
+    uint32_t limit; // One past the last image address
+    std::vector<uint8_t> flags;
+    std::vector<uint32_t> functions_;
+    std::vector<BasicBlock> blocks_;
+    std::vector<std::vector<uint32_t>> tables; // JP0 targets, indexed through table_of
+    std::vector<int32_t> table_of;             // JP0 address -> index into tables, or -1
+    size_t n_instructions = 0;
+    size_t n_overlaps = 0;
+
+    bool in_image(uint32_t addr, uint32_t len = 2) const { return addr >= origin && addr + len <= limit; }
+    uint16_t word(uint32_t addr) const { return (image[addr - origin] << 8) | image[addr - origin + 1]; }
+    void explore();
+    void build_blocks();
+    void assign_functions();
+    void successors(uint32_t addr, Flow flow, std::vector<uint32_t>& out) const;
+    bool write_label(TextBuffer& out, uint32_t addr) const;
+
+public:
+    // `data` is the ROM image loaded at `origin`. Bytes past DISASM_SPACE are ignored.
+    Disassembly(const uint8_t* data, size_t size, uint32_t origin = 0x200);
+
+    const std::vector<BasicBlock>& blocks() const { return blocks_; }
+    const std::vector<uint32_t>& functions() const { return functions_; }
+    bool is_code(uint32_t addr) const { return addr < DISASM_SPACE && (flags[addr] & F_CODE); }
+    bool covers(uint32_t addr) const { return addr < DISASM_SPACE && (flags[addr] & F_COVER); } // Any byte of an instruction
+    size_t instructions() const { return n_instructions; }
+    size_t overlaps() const { return n_overlaps; } // Instructions starting inside another one
+    size_t code_bytes() const;
+
+    // Label for an address: main, sub_xxxx, L_xxxx, data_xxxx, or empty
+    std::string label(uint32_t addr) const;
+
+    // Annotated listing with labels, function and block boundaries, and data as DB lines.
+    // The TextBuffer overload reuses the caller's buffer across many images.
+    void write_listing(std::ostream& out) const;
+    void write_listing(TextBuffer& buf, std::ostream& out) const;
+    // Control-flow graph in Graphviz DOT, one cluster per function
+    void write_dot(std::ostream& out, const std::string& name) const;
+};
+
+// Control flow of a single opcode, independent of where it sits
+Flow flow_of(uint16_t opcode);
+
+#endif
@@ -0,0 +1,119 @@
+#include "decode.hpp"
+
+const OpInfo op_info[static_cast<size_t>(OpKind::Count)] = {
+    {CMD_CLS, DESC_CLS, 0x00E0, ArgShape::None},
+    {CMD_RET, DESC_RET, 0x00EE, ArgShape::None},
+    {CMD_JP, DESC_JP, 0x1000, ArgShape::Addr},
+    {CMD_CALL, DESC_CALL, 0x2000, ArgShape::Addr},
+    {CMD_SE, DESC_SE, 0x3000, ArgShape::RegByte},
+    {CMD_SNE, DESC_SNE, 0x4000, ArgShape::RegByte},
+    {CMD_SEV, DESC_SEV, 0x5000, ArgShape::RegReg},
+    {CMD_SNEV, DESC_SNEV, 0x9000, ArgShape::RegReg},
+    {CMD_LDV, DESC_LDV, 0x6000, ArgShape::RegByte},
+    {CMD_ADDV, DESC_ADDV, 0x7000, ArgShape::RegByte},
+    {CMD_LDR, DESC_LDR, 0x8000, ArgShape::RegReg},
+    {CMD_OR, DESC_OR, 0x8001, ArgShape::RegReg},
+    {CMD_AND, DESC_AND, 0x8002, ArgShape::RegReg},
+    {CMD_XOR, DESC_XOR, 0x8003, ArgShape::RegReg},
+    {CMD_ADDR, DESC_ADDR, 0x8004, ArgShape::RegReg},
+    {CMD_SUB, DESC_SUB, 0x8005, ArgShape::RegReg},
+    {CMD_SUBN, DESC_SUBN, 0x8007, ArgShape::RegReg},
+    {CMD_SHR, DESC_SHR, 0x8006, ArgShape::RegReg},
+    {CMD_SHL, DESC_SHL, 0x800E, ArgShape::RegReg},
+    {CMD_LDI, DESC_LDI, 0xA000, ArgShape::Addr},
+    {CMD_JP0, DESC_JP0, 0xB000, ArgShape::Addr},
+    {CMD_RND, DESC_RND, 0xC000, ArgShape::RegByte},
+    {CMD_DRW, DESC_DRW, 0xD000, ArgShape::Sprite},
+    {CMD_SKP, DESC_SKP, 0xE09E, ArgShape::Reg},
+    {CMD_SKNP, DESC_SKNP, 0xE0A1, ArgShape::Reg},
+    {CMD_LDDT, DESC_LDDT, 0xF007, ArgShape::RegByte},
+    {CMD_STDT, DESC_STDT, 0xF015, ArgShape::RegByte},
+    {CMD_STST, DESC_STST, 0xF018, ArgShape::RegByte},
+    {CMD_ADD, DESC_ADD, 0xF01E, ArgShape::IndexReg},
+    {CMD_KEY, DESC_KEY, 0xF00A, ArgShape::Reg},
+    {CMD_LDF, DESC_LDF, 0xF029, ArgShape::Reg},
+    {CMD_BCD, DESC_BCD, 0xF033, ArgShape::Reg},
+    {CMD_STR, DESC_STR, 0xF055, ArgShape::IndexReg},
+    {CMD_LDRM, DESC_LDRM, 0xF065, ArgShape::IndexReg},
+    {CMD_AUDIO, DESC_AUDIO, 0xF002, ArgShape::Index},
+    {CMD_PITCH, DESC_PITCH, 0xF03A, ArgShape::Reg},
+    {CMD_UNK, DESC_UNK, 0x0000, ArgShape::Raw},
+};
+
+static constexpr OpKind classify(inst_t op) {
+    const uint8_t nn = op & 0xFF;
+    switch (op >> 12) {
+    case 0x0:
+        if (op == 0x00E0) return OpKind::Cls;
+        if (op == 0x00EE) return OpKind::Ret;
+        break;
+    case 0x1: return OpKind::Jp;
+    case 0x2: return OpKind::Call;
+    case 0x3: return OpKind::Se;
+    case 0x4: return OpKind::Sne;
+    case 0x5: if ((op & 0xF) == 0) return OpKind::Sev; break;
+    case 0x6: return OpKind::Ldv;
+    case 0x7: return OpKind::Addv;
+    case 0x8:
+        switch (op & 0xF) {
+        case 0x0: return OpKind::Ldr;
+        case 0x1: return OpKind::Or;
+        case 0x2: return OpKind::And;
+        case 0x3: return OpKind::Xor;
+        case 0x4: return OpKind::AddR;
+        case 0x5: return OpKind::Sub;
+        case 0x6: return OpKind::Shr;
+        case 0x7: return OpKind::Subn;
+        case 0xE: return OpKind::Shl;
+        }
+        break;
+    case 0x9: if ((op & 0xF) == 0) return OpKind::Snev; break;
+    case 0xA: return OpKind::Ldi;
+    case 0xB: return OpKind::Jp0;
+    case 0xC: return OpKind::Rnd;
+    case 0xD: return OpKind::Drw;
+    case 0xE:
+        if (nn == 0x9E) return OpKind::Skp;
+        if (nn == 0xA1) return OpKind::Sknp;
+        break;
+    case 0xF:
+        switch (nn) {
+        case 0x02: if (op == 0xF002) return OpKind::Audio; break;
+        case 0x07: return OpKind::LdDt;
+        case 0x0A: return OpKind::Key;
+        case 0x15: return OpKind::StDt;
+        case 0x18: return OpKind::StSt;
+        case 0x1E: return OpKind::AddI;
+        case 0x29: return OpKind::LdF;
+        case 0x33: return OpKind::Bcd;
+        case 0x3A: return OpKind::Pitch;
+        case 0x55: return OpKind::Str;
+        case 0x65: return OpKind::LdRm;
+        }
+        break;
+    }
+    return OpKind::Unknown;
+}
+
+static constexpr std::array<OpKind, 0x10000> build_decode_table() {
+    std::array<OpKind, 0x10000> table{};
+    for (uint32_t op = 0; op < 0x10000; op++) table[op] = classify(static_cast<inst_t>(op));
+    return table;
+}
+
+// constexpr so the table is constant-initialised: usable from other static initialisers
+constexpr std::array<OpKind, 0x10000> decode_table = build_decode_table();
+
+void DecodedInst::write_arg(TextBuffer& out) const {
+    switch (info().shape) {
+    case ArgShape::None: break;
+    case ArgShape::Addr: out.put("NNN=").put_hex(nnn(), 3); break;
+    case ArgShape::RegByte: out.put("X=").put_reg(x()).put(", NN=").put_hex(nn(), 2); break;
+    case ArgShape::RegReg: out.put("X=").put_reg(x()).put(", Y=").put_reg(y()); break;
+    case ArgShape::Reg: out.put("X=").put_reg(x()); break;
+    case ArgShape::Sprite: out.put("X=").put_reg(x()).put(", Y=").put_reg(y()).put(", N=").put_dec(n()); break;
+    case ArgShape::IndexReg: out.put("I, X=").put_reg(x()); break;
+    case ArgShape::Index: out.put("I"); break;
+    case ArgShape::Raw: out.put_hex(opcode, 4); break;
+    }
+}
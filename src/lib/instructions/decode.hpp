@@ -0,0 +1,76 @@
+#ifndef SRC_LIB_INSTRUCTIONS_DECODE_HPP
+#define SRC_LIB_INSTRUCTIONS_DECODE_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "../utils/format.hpp"
+#include "types.hpp"
+
+// Instruction kind, one per Inst class. Order matches instructions.hpp.
+enum class OpKind : uint8_t {
+    Cls, Ret, Jp, Call, Se, Sne, Sev, Snev, Ldv, Addv,
+    Ldr, Or, And, Xor, AddR, Sub, Subn, Shr, Shl,
+    Ldi, Jp0, Rnd, Drw, Skp, Sknp,
+    LdDt, StDt, StSt, AddI, Key, LdF, Bcd, Str, LdRm,
+    Audio, Pitch, Unknown,
+    Count
+};
+
+// Operand layout, which decides how arg() is written
+enum class ArgShape : uint8_t {
+    None,     //
+    Addr,     // NNN=0x123
+    RegByte,  // X=V1, NN=0x23
+    RegReg,   // X=V1, Y=V2
+    Reg,      // X=V1
+    Sprite,   // X=V1, Y=V2, N=3
+    IndexReg, // I, X=V1
+    Index,    // I
+    Raw,      // 0x1234
+};
+
+struct OpInfo {
+    std::string_view cmd;
+    std::string_view desc;
+    inst_t base; // Opcode with every operand field zero
+    ArgShape shape;
+};
+
+extern const OpInfo op_info[static_cast<size_t>(OpKind::Count)];
+
+// Kind of every 16-bit opcode, built at compile time. Decoding is one load.
+extern const std::array<OpKind, 0x10000> decode_table;
+
+inline OpKind decode(inst_t opcode) { return decode_table[opcode]; }
+
+// Flat decoded instruction: the opcode plus its kind, four bytes. Operand fields are
+// bit slices of the opcode, so they are computed rather than stored.
+struct DecodedInst {
+    inst_t opcode;
+    OpKind kind;
+
+    DecodedInst() = default;
+    explicit DecodedInst(inst_t opcode): opcode(opcode), kind(decode(opcode)) {}
+
+    uint8_t x() const { return (opcode >> 8) & 0x0F; }
+    uint8_t y() const { return (opcode >> 4) & 0x0F; }
+    uint8_t n() const { return opcode & 0x000F; }
+    uint8_t nn() const { return opcode & 0x00FF; }
+    uint16_t nnn() const { return opcode & 0x0FFF; }
+
+    const OpInfo& info() const { return op_info[static_cast<size_t>(kind)]; }
+    std::string_view cmd() const { return info().cmd; }
+    std::string_view desc() const { return info().desc; }
+    void write_arg(TextBuffer& out) const;
+    std::string arg() const {
+        TextBuffer out;
+        write_arg(out);
+        return std::string(out.view());
+    }
+};
+
+static_assert(sizeof(DecodedInst) == 4, "DecodedInst must stay four bytes");
+
+#endif
@@ -2,6 +2,7 @@
 #include "../chip8/chip8.hpp"
 #include <cstdint>
 #include <iostream>
+#include <algorithm>
 
 // Inst protected accessor implementations
 uint8_t* Inst::memory(Chip8& chip8) { return chip8.memory; }
@@ -10,36 +11,53 @@ uint16_t& Inst::I(Chip8& chip8) { return chip8.I; }
 uint16_t* Inst::stack(Chip8& chip8) { return chip8.stack; }
 uint8_t& Inst::sp(Chip8& chip8) { return chip8.sp; }
 uint8_t& Inst::delay(Chip8& chip8) { return chip8.delay; }
-uint8_t& Inst::sound(Chip8& chip8) { return chip8.sound; }
 uint8_t* Inst::V(Chip8& chip8) { return chip8.V; }
+uint8_t* Inst::pattern(Chip8& chip8) { return chip8.pattern; }
+uint8_t& Inst::pitch(Chip8& chip8) { return chip8.pitch; }
+uint32_t& Inst::pattern_gen(Chip8& chip8) { return chip8.pattern_gen; }
+uint64_t* Inst::display(Chip8& chip8) { return chip8.display; }
+void Inst::store(Chip8& chip8, uint16_t addr, uint8_t value) { chip8.store(addr, value); }
+void Inst::set_row(Chip8& chip8, uint8_t y, uint64_t row) { chip8.set_row(y, row); }
+void Inst::clear_display(Chip8& chip8) { chip8.clear_display(); }
+void Inst::set_sound(Chip8& chip8, uint8_t value) { chip8.set_sound(value); }
+void Inst::raise_fault(Chip8& chip8, Fault fault, uint16_t opcode) { chip8.raise_fault(fault, opcode); }
+void Inst::unknown_opcode(Chip8& chip8, uint16_t opcode) { chip8.unknown_opcode(opcode); }
+void Inst::jump(Chip8& chip8, uint16_t target) { chip8.jump(target); }
+uint8_t Inst::random_byte(Chip8& chip8) { return chip8.random_byte(); }
 
 // Base Inst execute - should never be called directly, but needed for vtable
-void Inst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void Inst::execute(Chip8& chip8, uint16_t keydown) {
     std::cerr << "Base Inst::execute() called - this should not happen\n";
 }
 
-void ClearScreen::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
-    std::fill(frame_buffer.begin(), frame_buffer.end(), 0xFF000000u);
+void ClearScreen::execute(Chip8& chip8, uint16_t keydown) {
+    clear_display(chip8);
 }
 
-void ReturnInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
-    if (sp(chip8) == 0) throw std::runtime_error("Stack underflow on RET instruction");
+void ReturnInst::execute(Chip8& chip8, uint16_t keydown) {
+    if (sp(chip8) == 0) {
+        raise_fault(chip8, Fault::StackUnderflow, inst);
+        return;
+    }
     sp(chip8)--;
     pc(chip8) = stack(chip8)[sp(chip8)];
 }
 
-void JumpInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
-    pc(chip8) = inst & 0x0FFF;
+void JumpInst::execute(Chip8& chip8, uint16_t keydown) {
+    jump(chip8, inst & 0x0FFF);
 }
 
-void SubroutInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
-    if (sp(chip8) >= 16) throw std::runtime_error("Stack overflow on CALL instruction");
+void SubroutInst::execute(Chip8& chip8, uint16_t keydown) {
+    if (sp(chip8) >= 16) {
+        raise_fault(chip8, Fault::StackOverflow, inst);
+        return;
+    }
     stack(chip8)[sp(chip8)] = pc(chip8);
     sp(chip8)++;
     pc(chip8) = inst & 0x0FFF;
 }
 
-void SkipConstEqInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SkipConstEqInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t NN = inst & 0x00FF;
     if (V(chip8)[X] == NN) {
@@ -47,7 +65,7 @@ void SkipConstEqInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer,
     }
 }
 
-void SkipConstNeqInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SkipConstNeqInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t NN = inst & 0x00FF;
     if (V(chip8)[X] != NN) {
@@ -55,7 +73,7 @@ void SkipConstNeqInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer
     }
 }
 
-void SkipRegEqInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SkipRegEqInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     if (V(chip8)[X] == V(chip8)[Y]) {
@@ -63,7 +81,7 @@ void SkipRegEqInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, i
     }
 }
 
-void SkipRegNeqInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SkipRegNeqInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     if (V(chip8)[X] != V(chip8)[Y]) {
@@ -71,42 +89,42 @@ void SkipRegNeqInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer,
     }
 } 
 
-void SetConstInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SetConstInst::execute(Chip8& chip8, uint16_t keydown) {
     V(chip8)[(inst >> 8) & 0x0F] = inst & 0x00FF;
 }
 
-void AddConstInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void AddConstInst::execute(Chip8& chip8, uint16_t keydown) {
     V(chip8)[(inst >> 8) & 0x0F] += inst & 0x00FF;
 }
 
-void LoadReg::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void LoadReg::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     V(chip8)[X] = V(chip8)[Y];
 }
 
-void OrReg::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void OrReg::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     V(chip8)[X] |= V(chip8)[Y];
     V(chip8)[0xF] = 0;
 }
 
-void AndReg::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void AndReg::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     V(chip8)[X] &= V(chip8)[Y];
     V(chip8)[0xF] = 0;
 }
 
-void XorReg::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void XorReg::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     V(chip8)[X] ^= V(chip8)[Y];
     V(chip8)[0xF] = 0;
 }
 
-void AddReg::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void AddReg::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     uint16_t sum = static_cast<uint16_t>(V(chip8)[X]) + V(chip8)[Y];
@@ -114,7 +132,7 @@ void AddReg::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int fram
     V(chip8)[0xF] = (sum > 0xFF) ? 1 : 0;
 }
 
-void SubXY::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SubXY::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     uint8_t X_val = V(chip8)[X];
@@ -124,7 +142,7 @@ void SubXY::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame
     V(chip8)[0xF] = vf;
 }
 
-void SubYX::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SubYX::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     uint8_t X_val = V(chip8)[X];
@@ -134,7 +152,7 @@ void SubYX::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame
     V(chip8)[0xF] = vf;
 }
 
-void ShiftRightInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void ShiftRightInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     uint8_t carry = V(chip8)[Y] & 0x01;
@@ -142,7 +160,7 @@ void ShiftRightInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer,
     V(chip8)[0xF] = carry;
 }
 
-void ShiftLeftInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void ShiftLeftInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t Y = (inst >> 4) & 0x0F;
     uint8_t carry = (V(chip8)[Y] & 0x80) >> 7;
@@ -150,81 +168,79 @@ void ShiftLeftInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, i
     V(chip8)[0xF] = carry;
 } 
 
-void SetIndexInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SetIndexInst::execute(Chip8& chip8, uint16_t keydown) {
     I(chip8) = inst & 0x0FFF;
 }
 
-void JumpOffsetInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void JumpOffsetInst::execute(Chip8& chip8, uint16_t keydown) {
     pc(chip8) = (inst & 0x0FFF) + V(chip8)[0];
 }
 
-void RandInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void RandInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t NN = inst & 0x00FF;
-    uint8_t rand_byte = static_cast<uint8_t>(rand() % 256);
+    uint8_t rand_byte = random_byte(chip8);
     V(chip8)[X] = rand_byte & NN;
 }
 
-void DisplayInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
-    uint8_t x_corr = V(chip8)[(inst >> 8) & 0x0F] % frame_width;
-    uint8_t y_corr = V(chip8)[(inst >> 4) & 0x0F] % frame_height;
+void DisplayInst::execute(Chip8& chip8, uint16_t keydown) {
+    uint8_t x_corr = V(chip8)[(inst >> 8) & 0x0F] % DISPLAY_WIDTH;
+    uint8_t y_corr = V(chip8)[(inst >> 4) & 0x0F] % DISPLAY_HEIGHT;
     uint8_t vf = 0;
     uint8_t n_rows = inst & 0x0F;
     for (uint8_t row = 0; row < n_rows; ++row) {
-        uint8_t sprite_byte = memory(chip8)[I(chip8) + row];
-        for (uint8_t col = 0; col < 8; ++col) {
-            if ((sprite_byte & (0x80 >> col)) != 0) {
-                uint16_t x = (x_corr + col) % frame_width;
-                uint16_t y = (y_corr + row) % frame_height;
-                uint32_t& pixel = frame_buffer[y * frame_width + x];
-                if (pixel != 0xFF000000u) {
-                    vf = 1;
-                }
-                pixel ^= 0x00FFFFFFu;
-            }
+        // Place the sprite byte at column 0 of a packed row, then rotate it into place so
+        // pixels past the right edge wrap around to the left
+        uint64_t sprite_row = static_cast<uint64_t>(memory(chip8)[(I(chip8) + row) & MEM_MASK]) << 56;
+        if (x_corr) sprite_row = (sprite_row >> x_corr) | (sprite_row << (DISPLAY_WIDTH - x_corr));
+        uint8_t y = (y_corr + row) % DISPLAY_HEIGHT;
+        uint64_t pixels = display(chip8)[y];
+        if (pixels & sprite_row) {
+            vf = 1;
         }
+        set_row(chip8, y, pixels ^ sprite_row);
     }
     V(chip8)[0xF] = vf;
 }
 
 
-void SkipIfKPInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SkipIfKPInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
-    uint8_t key = V(chip8)[X];
+    uint8_t key = V(chip8)[X] & 0x0F;
     if (keydown & (1 << key)) {
         pc(chip8) += 2;
     }
 }
 
-void SkipIfNotKPInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void SkipIfNotKPInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
-    uint8_t key = V(chip8)[X];
+    uint8_t key = V(chip8)[X] & 0x0F;
     if (!(keydown & (1 << key))) {
         pc(chip8) += 2;
     }
 }
 
-void TimerSetVXInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void TimerSetVXInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     V(chip8)[X] = delay(chip8);
 }
 
-void TimerSetDelayInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void TimerSetDelayInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     delay(chip8) = V(chip8)[X];
 }
 
-void TimerSetSoundInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void TimerSetSoundInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
-    sound(chip8) = V(chip8)[X];
+    set_sound(chip8, V(chip8)[X]);
 }
 
-void AddIRegInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void AddIRegInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     I(chip8) += V(chip8)[X];
 }
 
-void GetKeyInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void GetKeyInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     if (keydown == 0) {
         pc(chip8) -= 2; // Repeat this instruction
@@ -238,36 +254,48 @@ void GetKeyInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int
     }
 }
 
-void FontCharInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void FontCharInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t digit = V(chip8)[X] & 0x0F;
     I(chip8) = 0x50 + (digit * 5);
 }
 
-void BinCodedDecConvInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void BinCodedDecConvInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     uint8_t value = V(chip8)[X];
-    memory(chip8)[I(chip8) + 2] = value % 10;
+    store(chip8, I(chip8) + 2, value % 10);
     value /= 10;
-    memory(chip8)[I(chip8) + 1] = value % 10;
+    store(chip8, I(chip8) + 1, value % 10);
     value /= 10;
-    memory(chip8)[I(chip8) + 0] = value % 10;
+    store(chip8, I(chip8), value % 10);
 }
 
-void StoreMemInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void StoreMemInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     for (uint8_t i = 0; i <= X; ++i) {
-        memory(chip8)[I(chip8)++] = V(chip8)[i];
+        store(chip8, I(chip8)++, V(chip8)[i]);
     }
 }
 
-void LoadMemInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
+void LoadMemInst::execute(Chip8& chip8, uint16_t keydown) {
     uint8_t X = (inst >> 8) & 0x0F;
     for (uint8_t i = 0; i <= X; ++i) {
-        V(chip8)[i] = memory(chip8)[I(chip8)++];
+        V(chip8)[i] = memory(chip8)[I(chip8)++ & MEM_MASK];
     }
 }
 
-void UnknownInst::execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
-    std::cerr << "Unknown instruction: " << fmt("0x%s", hex(inst, 4)) << "\n";
+void AudioPatternInst::execute(Chip8& chip8, uint16_t keydown) {
+    for (uint8_t i = 0; i < 16; ++i) {
+        pattern(chip8)[i] = memory(chip8)[(I(chip8) + i) & MEM_MASK];
+    }
+    pattern_gen(chip8)++;
+}
+
+void PitchInst::execute(Chip8& chip8, uint16_t keydown) {
+    uint8_t X = (inst >> 8) & 0x0F;
+    pitch(chip8) = V(chip8)[X];
+}
+
+void UnknownInst::execute(Chip8& chip8, uint16_t keydown) {
+    unknown_opcode(chip8, inst);
 }
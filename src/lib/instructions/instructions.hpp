@@ -10,6 +10,7 @@
 #include "types.hpp"
 
 class Chip8;
+enum class Fault : uint8_t;
 
 // 16-bit instruction type
 class Inst {
@@ -17,10 +18,16 @@ public:
     inst_t inst;
     Inst(inst_t i): inst(i) {}
     virtual ~Inst() = default;
-    virtual const char* cmd() const { return CMD_UNK; }
-    virtual std::string desc() const { return DESC_UNK; }
-    virtual std::string arg() const { return ""; }
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) = 0;
+    virtual std::string_view cmd() const { return CMD_UNK; }
+    virtual std::string_view desc() const { return DESC_UNK; }
+    // Operands in text form, appended without going through a stream
+    virtual void write_arg(TextBuffer& out) const {}
+    std::string arg() const {
+        TextBuffer out;
+        write_arg(out);
+        return std::string(out.view());
+    }
+    virtual void execute(Chip8& chip8, uint16_t keydown) = 0;
     static bool match(inst_t opcode) { return false; }
 
 protected:
@@ -31,16 +38,28 @@ protected:
     static inline uint16_t* stack(Chip8& chip8);
     static inline uint8_t& sp(Chip8& chip8);
     static inline uint8_t& delay(Chip8& chip8);
-    static inline uint8_t& sound(Chip8& chip8);
     static inline uint8_t* V(Chip8& chip8);
+    static inline uint8_t* pattern(Chip8& chip8);
+    static inline uint8_t& pitch(Chip8& chip8);
+    static inline uint32_t& pattern_gen(Chip8& chip8);
+    static inline uint64_t* display(Chip8& chip8);
+    // Writes that keep the machine's incremental state hash in step
+    static inline void store(Chip8& chip8, uint16_t addr, uint8_t value);
+    static inline void set_row(Chip8& chip8, uint8_t y, uint64_t row);
+    static inline void clear_display(Chip8& chip8);
+    static inline void set_sound(Chip8& chip8, uint8_t value);
+    static inline void raise_fault(Chip8& chip8, Fault fault, uint16_t opcode);
+    static void unknown_opcode(Chip8& chip8, uint16_t opcode);
+    static inline void jump(Chip8& chip8, uint16_t target);
+    static inline uint8_t random_byte(Chip8& chip8);
 };
 
 template <typename T>
 class InstTrait: public Inst {
 public:
     InstTrait(inst_t inst): Inst(inst) {}
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) {
-        std::cerr << static_cast<T*>(this)->cmd() << "(" << static_cast<T*>(this)->arg() << ")" << " instruction execution not implemented.\n";
+    virtual void execute(Chip8& chip8, uint16_t keydown) {
+        unknown_opcode(chip8, inst);
     }
 
     static bool match(inst_t opcode) {
@@ -54,19 +73,15 @@ public:
     static const inst_t op = 0x00E0;
     ClearScreen(inst_t inst): InstTrait<ClearScreen>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_CLS;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_CLS;
     }
     
-    virtual std::string arg() const override {
-        return "";
-    }
-
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class ReturnInst: public InstTrait<ReturnInst> {
@@ -76,19 +91,15 @@ public:
 
     ReturnInst(inst_t inst): InstTrait<ReturnInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_RET;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_RET;
     }
     
-    virtual std::string arg() const override {
-        return "";
-    }
-
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class JumpInst: public InstTrait<JumpInst> {
@@ -98,19 +109,19 @@ public:
 
     JumpInst(inst_t inst): InstTrait<JumpInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_JP;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_JP;
     }
     
-    virtual std::string arg() const override {
-        return fmt("NNN=%s", hex(inst & 0x0FFF, 3));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("NNN=").put_hex(inst & 0x0FFF, 3);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SubroutInst: public InstTrait<SubroutInst> {
@@ -120,19 +131,19 @@ public:
 
     SubroutInst(inst_t inst): InstTrait<SubroutInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_CALL;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_CALL;
     }
     
-    virtual std::string arg() const override {
-        return fmt("NNN=%s", hex(inst & 0x0FFF, 3));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("NNN=").put_hex(inst & 0x0FFF, 3);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SkipConstEqInst: public InstTrait<SkipConstEqInst> {
@@ -142,19 +153,19 @@ public:
 
     SkipConstEqInst(inst_t inst): InstTrait<SkipConstEqInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SE;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SE;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, NN=%s", reg(inst >> 8), hex(inst & 0xFF, 2));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", NN=").put_hex(inst & 0xFF, 2);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SkipConstNeqInst: public InstTrait<SkipConstNeqInst> {
@@ -164,19 +175,19 @@ public:
 
     SkipConstNeqInst(inst_t inst): InstTrait<SkipConstNeqInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SNE;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SNE;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, NN=%s", reg(inst >> 8), hex(inst & 0xFF, 2));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", NN=").put_hex(inst & 0xFF, 2);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SkipRegEqInst: public InstTrait<SkipRegEqInst> {
@@ -186,19 +197,19 @@ public:
 
     SkipRegEqInst(inst_t inst): InstTrait<SkipRegEqInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SEV;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SEV;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SkipRegNeqInst: public InstTrait<SkipRegNeqInst> {
@@ -208,19 +219,19 @@ public:
 
     SkipRegNeqInst(inst_t inst): InstTrait<SkipRegNeqInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SNEV;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SNEV;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SetConstInst: public InstTrait<SetConstInst> {
@@ -230,19 +241,19 @@ public:
 
     SetConstInst(inst_t inst): InstTrait<SetConstInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_LDV;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_LDV;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, NN=%s", reg(inst >> 8), hex(inst & 0xFF, 2));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", NN=").put_hex(inst & 0xFF, 2);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class AddConstInst: public InstTrait<AddConstInst> {
@@ -252,19 +263,19 @@ public:
 
     AddConstInst(inst_t inst): InstTrait<AddConstInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_ADDV;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_ADDV;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, NN=%s", reg(inst >> 8), hex(inst & 0xFF, 2));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", NN=").put_hex(inst & 0xFF, 2);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class LoadReg: public InstTrait<LoadReg> {
@@ -274,19 +285,19 @@ public:
 
     LoadReg(inst_t inst): InstTrait<LoadReg>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_LDR;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_LDR;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class OrReg: public InstTrait<OrReg> {
@@ -296,19 +307,19 @@ public:
 
     OrReg(inst_t inst): InstTrait<OrReg>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_OR;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_OR;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class AndReg: public InstTrait<AndReg> {
@@ -318,19 +329,19 @@ public:
 
     AndReg(inst_t inst): InstTrait<AndReg>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_AND;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_AND;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class XorReg: public InstTrait<XorReg> {
@@ -340,19 +351,19 @@ public:
 
     XorReg(inst_t inst): InstTrait<XorReg>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_XOR;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_XOR;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class AddReg: public InstTrait<AddReg> {
@@ -362,19 +373,19 @@ public:
 
     AddReg(inst_t inst): InstTrait<AddReg>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_ADDR;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_ADDR;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SubXY: public InstTrait<SubXY> {
@@ -383,19 +394,19 @@ public:
     static const inst_t op = 0x8005;
     SubXY(inst_t inst): InstTrait<SubXY>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SUB;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SUB;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SubYX: public InstTrait<SubYX> {
@@ -405,19 +416,19 @@ public:
 
     SubYX(inst_t inst): InstTrait<SubYX>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SUBN;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SUBN;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s", reg(inst >> 8), reg(inst >> 4));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class ShiftRightInst: public InstTrait<ShiftRightInst> {
@@ -427,19 +438,19 @@ public:
 
     ShiftRightInst(inst_t inst): InstTrait<ShiftRightInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SHR;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SHR;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class ShiftLeftInst: public InstTrait<ShiftLeftInst> {
@@ -449,19 +460,19 @@ public:
 
     ShiftLeftInst(inst_t inst): InstTrait<ShiftLeftInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SHL;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SHL;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SetIndexInst: public InstTrait<SetIndexInst> {
@@ -471,19 +482,19 @@ public:
 
     SetIndexInst(inst_t inst): InstTrait<SetIndexInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_LDI;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_LDI;
     }
     
-    virtual std::string arg() const override {
-        return fmt("NNN=%s", hex(inst & 0x0FFF, 3));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("NNN=").put_hex(inst & 0x0FFF, 3);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class JumpOffsetInst: public InstTrait<JumpOffsetInst> {
@@ -493,19 +504,19 @@ public:
 
     JumpOffsetInst(inst_t inst): InstTrait<JumpOffsetInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_JP0;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_JP0;
     }
     
-    virtual std::string arg() const override {
-        return fmt("NNN=%s", hex(inst & 0x0FFF, 3));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("NNN=").put_hex(inst & 0x0FFF, 3);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class RandInst: public InstTrait<RandInst> {
@@ -515,19 +526,19 @@ public:
 
     RandInst(inst_t inst): InstTrait<RandInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_RND;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_RND;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, NN=%s", reg(inst >> 8), hex(inst & 0xFF, 2));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", NN=").put_hex(inst & 0xFF, 2);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class DisplayInst: public InstTrait<DisplayInst> {
@@ -537,19 +548,19 @@ public:
 
     DisplayInst(inst_t inst): InstTrait<DisplayInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_DRW;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_DRW;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, Y=%s, N=%s", reg(inst >> 8), reg(inst >> 4), std::to_string(inst & 0xF));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", Y=").put_reg(inst >> 4).put(", N=").put_dec(inst & 0xF);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SkipIfKPInst: public InstTrait<SkipIfKPInst> {
@@ -559,19 +570,19 @@ public:
 
     SkipIfKPInst(inst_t inst): InstTrait<SkipIfKPInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SKP;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SKP;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class SkipIfNotKPInst: public InstTrait<SkipIfNotKPInst> {
@@ -581,19 +592,19 @@ public:
 
     SkipIfNotKPInst(inst_t inst): InstTrait<SkipIfNotKPInst>(inst) {}
 
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_SKNP;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_SKNP;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class TimerSetVXInst: public InstTrait<TimerSetVXInst> {
@@ -603,19 +614,19 @@ public:
 
     TimerSetVXInst(inst_t inst): InstTrait<TimerSetVXInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_LDDT;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_LDDT;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, NN=%s", reg(inst >> 8), hex(inst & 0xFF, 2));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", NN=").put_hex(inst & 0xFF, 2);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 class TimerSetDelayInst: public InstTrait<TimerSetDelayInst> {
 public:
@@ -624,19 +635,19 @@ public:
 
     TimerSetDelayInst(inst_t inst): InstTrait<TimerSetDelayInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_STDT;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_STDT;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, NN=%s", reg(inst >> 8), hex(inst & 0xFF, 2));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", NN=").put_hex(inst & 0xFF, 2);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class TimerSetSoundInst: public InstTrait<TimerSetSoundInst> {
@@ -646,19 +657,19 @@ public:
 
     TimerSetSoundInst(inst_t inst): InstTrait<TimerSetSoundInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_STST;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_STST;
     }
     
-    virtual std::string arg() const override {
-        return fmt("X=%s, NN=%s", reg(inst >> 8), hex(inst & 0xFF, 2));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8).put(", NN=").put_hex(inst & 0xFF, 2);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class AddIRegInst: public InstTrait<AddIRegInst> {
@@ -667,19 +678,19 @@ public:
     static const inst_t op = 0xF01E;
     AddIRegInst(inst_t inst): InstTrait<AddIRegInst>(inst) {}
 
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_ADD;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_ADD;
     }
 
-    virtual std::string arg() const override {
-        return fmt("I, X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("I, X=").put_reg(inst >> 8);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class GetKeyInst: public InstTrait<GetKeyInst> {
@@ -687,19 +698,19 @@ public:
     static const inst_t mask = 0xF0FF;
     static const inst_t op = 0xF00A;
     GetKeyInst(inst_t inst): InstTrait<GetKeyInst>(inst) {}
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_KEY;
     }
 
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_KEY;
     }
 
-    virtual std::string arg() const override {
-        return fmt("X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class FontCharInst: public InstTrait<FontCharInst> {
@@ -707,19 +718,19 @@ public:
     static const inst_t mask = 0xF0FF;
     static const inst_t op = 0xF029;
     FontCharInst(inst_t inst): InstTrait<FontCharInst>(inst) {}
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_LDF;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_LDF;
     }
 
-    virtual std::string arg() const override {
-        return fmt("X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class BinCodedDecConvInst: public InstTrait<BinCodedDecConvInst> {
@@ -727,19 +738,19 @@ public:
     static const inst_t mask = 0xF0FF;
     static const inst_t op = 0xF033;
     BinCodedDecConvInst(inst_t inst): InstTrait<BinCodedDecConvInst>(inst) {}
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_BCD;
     }
 
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_BCD;
     }
 
-    virtual std::string arg() const override {
-        return fmt("X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class StoreMemInst: public InstTrait<StoreMemInst> {
@@ -747,16 +758,16 @@ public:
     static const inst_t mask = 0xF0FF;
     static const inst_t op = 0xF055;
     StoreMemInst(inst_t inst): InstTrait<StoreMemInst>(inst) {}
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_STR;
     }
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_STR;
     }
-    virtual std::string arg() const override {
-        return fmt("I, X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("I, X=").put_reg(inst >> 8);
     }
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class LoadMemInst: public InstTrait<LoadMemInst> {
@@ -764,16 +775,50 @@ public:
     static const inst_t mask = 0xF0FF;
     static const inst_t op = 0xF065;
     LoadMemInst(inst_t inst): InstTrait<LoadMemInst>(inst) {}
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_LDRM;
     }
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_LDRM;
     }
-    virtual std::string arg() const override {
-        return fmt("I, X=%s", reg(inst >> 8));
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("I, X=").put_reg(inst >> 8);
+    }
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
+};
+
+class AudioPatternInst: public InstTrait<AudioPatternInst> {
+public:
+    static const inst_t mask = 0xFFFF;
+    static const inst_t op = 0xF002;
+    AudioPatternInst(inst_t inst): InstTrait<AudioPatternInst>(inst) {}
+    virtual std::string_view cmd() const override {
+        return CMD_AUDIO;
+    }
+    virtual std::string_view desc() const override {
+        return DESC_AUDIO;
+    }
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("I");
+    }
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
+};
+
+class PitchInst: public InstTrait<PitchInst> {
+public:
+    static const inst_t mask = 0xF0FF;
+    static const inst_t op = 0xF03A;
+    PitchInst(inst_t inst): InstTrait<PitchInst>(inst) {}
+    virtual std::string_view cmd() const override {
+        return CMD_PITCH;
+    }
+    virtual std::string_view desc() const override {
+        return DESC_PITCH;
+    }
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put("X=").put_reg(inst >> 8);
     }
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 class UnknownInst: public InstTrait<UnknownInst> {
@@ -783,19 +828,19 @@ public:
 
     UnknownInst(inst_t inst): InstTrait<UnknownInst>(inst) {}
     
-    virtual const char* cmd() const override {
+    virtual std::string_view cmd() const override {
         return CMD_UNK;
     }
     
-    virtual std::string desc() const override {
+    virtual std::string_view desc() const override {
         return DESC_UNK;
     }
     
-    virtual std::string arg() const override {
-        return hex(inst, 4);
+    virtual void write_arg(TextBuffer& out) const override {
+        out.put_hex(inst, 4);
     }
 
-    virtual void execute(Chip8& chip8, std::vector<uint32_t>& frame_buffer, int frame_width, int frame_height, uint16_t keydown) override;
+    virtual void execute(Chip8& chip8, uint16_t keydown) override;
 };
 
 #endif
\ No newline at end of file
@@ -2,7 +2,9 @@
 #define SRC_LIB_INSTRUCTIONS_PARSER_HPP
 
 #include <memory>
+#include "decode.hpp"
 #include "instructions.hpp"
+#include "../rom/rom.hpp"
 
 #include <ios>
 #include <iostream>
@@ -16,23 +18,18 @@ protected:
     std::vector<inst_t> insts;
 public:
     Chip8Decompiler(const char* filename): filename(filename) {
-        std::ifstream fstream(filename, std::ios::binary);
-        if (!fstream.is_open()) {
-            throw std::runtime_error("Failed to open file");
-        }
-        char buffer[2];
-        while (fstream.read(buffer, 2)) {
-            u_int8_t hi = static_cast<u_int8_t>(buffer[0]);
-            u_int8_t lo = static_cast<u_int8_t>(buffer[1]);
-            u_int16_t inst = hi << 8 | lo;
-            insts.push_back(inst);
+        MappedRom rom(filename);
+        const uint8_t* bytes = rom.data();
+        insts.resize(rom.size() / 2);
+        for (size_t i = 0; i < insts.size(); i++) {
+            insts[i] = static_cast<inst_t>(bytes[i * 2] << 8 | bytes[i * 2 + 1]);
         }
     }
 
     friend std::ostream& operator<<(std::ostream&, const Chip8Decompiler&);
 };
 
-std::ostream& operator<<(std::ostream& out, const Chip8Decompiler& decompiler) {
+inline std::ostream& operator<<(std::ostream& out, const Chip8Decompiler& decompiler) {
     out << "=== " << decompiler.filename << " ===\n";
     for (inst_t i: decompiler.insts) {
         out << std::hex << i << "\n";
@@ -43,72 +40,84 @@ std::ostream& operator<<(std::ostream& out, const Chip8Decompiler& decompiler) {
 
 class Chip8Parser: public Chip8Decompiler {
 protected:
-    std::vector<std::unique_ptr<Inst>> parsed_insts;
+    std::vector<DecodedInst> decoded;
 public:
     Chip8Parser(const char* filename): Chip8Decompiler(filename) {
+        decoded.reserve(insts.size());
         for (inst_t i: insts) {
-            parsed_insts.push_back(parse(i));
+            decoded.emplace_back(i);
         }
     }
 
+    // Executable instruction object for the reference engine, picked through decode()
     static std::unique_ptr<Inst> parse(inst_t op) {
-        if (ClearScreen::match(op)) return std::make_unique<ClearScreen>(op);
-        else if (ReturnInst::match(op)) return std::make_unique<ReturnInst>(op);
-        else if (JumpInst::match(op)) return std::make_unique<JumpInst>(op);
-        else if (SubroutInst::match(op)) return std::make_unique<SubroutInst>(op);
-        else if (SkipConstEqInst::match(op)) return std::make_unique<SkipConstEqInst>(op);
-        else if (SkipConstNeqInst::match(op)) return std::make_unique<SkipConstNeqInst>(op);
-        else if (SkipRegEqInst::match(op)) return std::make_unique<SkipRegEqInst>(op);
-        else if (SkipRegNeqInst::match(op)) return std::make_unique<SkipRegNeqInst>(op);
-        else if (SetConstInst::match(op)) return std::make_unique<SetConstInst>(op);
-        else if (AddConstInst::match(op)) return std::make_unique<AddConstInst>(op);
-        else if (LoadReg::match(op)) return std::make_unique<LoadReg>(op);
-        else if (OrReg::match(op)) return std::make_unique<OrReg>(op);
-        else if (AndReg::match(op)) return std::make_unique<AndReg>(op);
-        else if (XorReg::match(op)) return std::make_unique<XorReg>(op);
-        else if (AddReg::match(op)) return std::make_unique<AddReg>(op);
-        else if (SubXY::match(op)) return std::make_unique<SubXY>(op);
-        else if (SubYX::match(op)) return std::make_unique<SubYX>(op);
-        else if (ShiftRightInst::match(op)) return std::make_unique<ShiftRightInst>(op);
-        else if (ShiftLeftInst::match(op)) return std::make_unique<ShiftLeftInst>(op);
-        else if (SetIndexInst::match(op)) return std::make_unique<SetIndexInst>(op);
-        else if (JumpOffsetInst::match(op)) return std::make_unique<JumpOffsetInst>(op);
-        else if (RandInst::match(op)) return std::make_unique<RandInst>(op);
-        else if (DisplayInst::match(op)) return std::make_unique<DisplayInst>(op);
-        else if (SkipIfKPInst::match(op)) return std::make_unique<SkipIfKPInst>(op);
-        else if (SkipIfNotKPInst::match(op)) return std::make_unique<SkipIfNotKPInst>(op);
-        else if (TimerSetVXInst::match(op)) return std::make_unique<TimerSetVXInst>(op);
-        else if (TimerSetDelayInst::match(op)) return std::make_unique<TimerSetDelayInst>(op);
-        else if (TimerSetSoundInst::match(op)) return std::make_unique<TimerSetSoundInst>(op);
-        else if (AddIRegInst::match(op)) return std::make_unique<AddIRegInst>(op);
-        else if (GetKeyInst::match(op)) return std::make_unique<GetKeyInst>(op);
-        else if (FontCharInst::match(op)) return std::make_unique<FontCharInst>(op);
-        else if (BinCodedDecConvInst::match(op)) return std::make_unique<BinCodedDecConvInst>(op);
-        else if (StoreMemInst::match(op)) return std::make_unique<StoreMemInst>(op);
-        else if (LoadMemInst::match(op)) return std::make_unique<LoadMemInst>(op);
-        else if (UnknownInst::match(op)) return std::make_unique<UnknownInst>(op);
-        else return std::make_unique<UnknownInst>(op);
+        switch (decode(op)) {
+        case OpKind::Cls: return std::make_unique<ClearScreen>(op);
+        case OpKind::Ret: return std::make_unique<ReturnInst>(op);
+        case OpKind::Jp: return std::make_unique<JumpInst>(op);
+        case OpKind::Call: return std::make_unique<SubroutInst>(op);
+        case OpKind::Se: return std::make_unique<SkipConstEqInst>(op);
+        case OpKind::Sne: return std::make_unique<SkipConstNeqInst>(op);
+        case OpKind::Sev: return std::make_unique<SkipRegEqInst>(op);
+        case OpKind::Snev: return std::make_unique<SkipRegNeqInst>(op);
+        case OpKind::Ldv: return std::make_unique<SetConstInst>(op);
+        case OpKind::Addv: return std::make_unique<AddConstInst>(op);
+        case OpKind::Ldr: return std::make_unique<LoadReg>(op);
+        case OpKind::Or: return std::make_unique<OrReg>(op);
+        case OpKind::And: return std::make_unique<AndReg>(op);
+        case OpKind::Xor: return std::make_unique<XorReg>(op);
+        case OpKind::AddR: return std::make_unique<AddReg>(op);
+        case OpKind::Sub: return std::make_unique<SubXY>(op);
+        case OpKind::Subn: return std::make_unique<SubYX>(op);
+        case OpKind::Shr: return std::make_unique<ShiftRightInst>(op);
+        case OpKind::Shl: return std::make_unique<ShiftLeftInst>(op);
+        case OpKind::Ldi: return std::make_unique<SetIndexInst>(op);
+        case OpKind::Jp0: return std::make_unique<JumpOffsetInst>(op);
+        case OpKind::Rnd: return std::make_unique<RandInst>(op);
+        case OpKind::Drw: return std::make_unique<DisplayInst>(op);
+        case OpKind::Skp: return std::make_unique<SkipIfKPInst>(op);
+        case OpKind::Sknp: return std::make_unique<SkipIfNotKPInst>(op);
+        case OpKind::LdDt: return std::make_unique<TimerSetVXInst>(op);
+        case OpKind::StDt: return std::make_unique<TimerSetDelayInst>(op);
+        case OpKind::StSt: return std::make_unique<TimerSetSoundInst>(op);
+        case OpKind::AddI: return std::make_unique<AddIRegInst>(op);
+        case OpKind::Key: return std::make_unique<GetKeyInst>(op);
+        case OpKind::LdF: return std::make_unique<FontCharInst>(op);
+        case OpKind::Bcd: return std::make_unique<BinCodedDecConvInst>(op);
+        case OpKind::Str: return std::make_unique<StoreMemInst>(op);
+        case OpKind::LdRm: return std::make_unique<LoadMemInst>(op);
+        case OpKind::Audio: return std::make_unique<AudioPatternInst>(op);
+        case OpKind::Pitch: return std::make_unique<PitchInst>(op);
+        default: return std::make_unique<UnknownInst>(op);
+        }
     }
 
-    const std::vector<std::unique_ptr<Inst>>& getInstructions() const {
-        return parsed_insts;
+    const std::vector<DecodedInst>& getInstructions() const {
+        return decoded;
+    }
+
+    // Flat listing built in `buf` and flushed to `out` in large writes. Passing the same
+    // buffer for many files avoids reallocating it.
+    void write(TextBuffer& buf, std::ostream& out) const {
+        buf.put("=== ").put(filename).put(" ===\n");
+        for (size_t i = 0; i < decoded.size(); i++) {
+            const DecodedInst& inst = decoded[i];
+            buf.put('[').put_dec(i).put(", addr: ").put_hex(0x200 + i * 2, 4).put("] ")
+               .put_hex(inst.opcode, 0, false).put(": ").put(inst.cmd()).put(' ');
+            inst.write_arg(buf);
+            buf.put(" -- ").put(inst.desc()).put('\n');
+            if (buf.size() >= LISTING_FLUSH_SIZE) buf.flush(out);
+        }
+        buf.put("=== END ===");
+        buf.flush(out);
     }
 
     friend std::ostream& operator<<(std::ostream&, const Chip8Parser&);
 };
 
-std::ostream& operator<<(std::ostream& out, const Chip8Parser& parser) {
-    out << "=== " << parser.filename << " ===\n";
-    const std::vector<std::unique_ptr<Inst>>& insts = parser.getInstructions();
-    for (int i = 0; i < insts.size(); i++) {
-        const std::unique_ptr<Inst>& inst_ptr = insts[i];
-        out << fmt("[%s, addr: %s] ", i, hex(0x200 + i * 2, 4))
-            << std::hex << (inst_ptr->inst) << ": "
-            << inst_ptr->cmd() << " "
-            << inst_ptr->arg() << " -- "
-            << inst_ptr->desc() << "\n";
-    }
-    out << "=== END ===";
+inline std::ostream& operator<<(std::ostream& out, const Chip8Parser& parser) {
+    TextBuffer buf;
+    parser.write(buf, out);
     return out;
 }
 
@@ -40,6 +40,8 @@ using inst_t = uint16_t;
 #define CMD_BCD "BCD"
 #define CMD_STR "STR"
 #define CMD_LDRM "LD.RM"
+#define CMD_AUDIO "AUDIO"
+#define CMD_PITCH "PITCH"
 #define CMD_UNK "UNK"
 
 // Instruction descriptions
@@ -77,6 +79,8 @@ using inst_t = uint16_t;
 #define DESC_BCD "Store BCD of Vx at I, I+1, I+2"
 #define DESC_STR "Store V0-Vx in memory at I"
 #define DESC_LDRM "Load V0-Vx from memory at I"
+#define DESC_AUDIO "Load 16-byte audio pattern from I"
+#define DESC_PITCH "Set audio pitch to Vx"
 #define DESC_UNK "Unknown instruction"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include "rom.hpp"
+#include "../chip8/chip8.hpp"
+#include "../utils/hash.hpp"
+
+MappedRom::MappedRom(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Failed to open file " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to stat file " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Failed to map file " + path);
+        }
+        bytes = static_cast<const uint8_t*>(mapping);
+    }
+    close(fd); // The mapping stays valid after the descriptor is closed
+}
+
+MappedRom::~MappedRom() {
+    if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+}
+
+MappedRom::MappedRom(MappedRom&& other) noexcept : bytes(other.bytes), length(other.length) {
+    other.bytes = nullptr;
+    other.length = 0;
+}
+
+MappedRom& MappedRom::operator=(MappedRom&& other) noexcept {
+    if (this != &other) {
+        if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+        bytes = other.bytes;
+        length = other.length;
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+const char* platform_name(Platform platform) {
+    switch (platform) {
+        case Platform::Chip8: return "chip8";
+        case Platform::SChip: return "schip";
+        case Platform::XOChip: return "xochip";
+    }
+    return "unknown";
+}
+
+std::string quirk_names(uint8_t quirks) {
+    static const char* names[] = {"vf-reset", "memory", "shift", "jump", "display"};
+    std::string out;
+    for (int i = 0; i < 5; i++) {
+        if (!(quirks & (1 << i))) continue;
+        if (!out.empty()) out += ",";
+        out += names[i];
+    }
+    return out.empty() ? "none" : out;
+}
+
+// Byte offsets of the words reachable from the entry point. Follows jumps, calls and
+// both sides of skips; stops at returns, exits and computed jumps (Bnnn).
+static std::vector<bool> reachable(const uint8_t* data, size_t size) {
+    std::vector<bool> seen(size);
+    std::vector<size_t> pending = {0};
+    auto target = [&](uint16_t addr) {
+        if (addr >= MEM_START && addr - MEM_START + 1u < size) pending.push_back(addr - MEM_START);
+    };
+    while (!pending.empty()) {
+        size_t at = pending.back();
+        pending.pop_back();
+        while (at + 1 < size && !seen[at]) {
+            seen[at] = true;
+            uint16_t op = (data[at] << 8) | data[at + 1];
+            uint8_t hi = op >> 12;
+            uint8_t nn = op & 0xFF;
+            if (op == 0x00EE || op == 0x00FD || hi == 0xB) break;
+            if (hi == 0x1) {
+                target(op & 0x0FFF);
+                break;
+            }
+            if (hi == 0x2) target(op & 0x0FFF);
+            if (hi == 0x3 || hi == 0x4 || hi == 0x5 || hi == 0x9 || (hi == 0xE && (nn == 0x9E || nn == 0xA1))) {
+                pending.push_back(at + 4);
+            }
+            at += op == 0xF000 ? 4 : 2; // XO-CHIP long load of I takes the next word
+        }
+    }
+    return seen;
+}
+
+RomInfo analyze_rom(const uint8_t* data, size_t size) {
+    RomInfo info;
+    info.hash = hash_bytes(data, size);
+    info.size = static_cast<uint32_t>(size);
+    bool schip = false;
+    bool xochip = size > MEM_SIZE - MEM_START;
+
+    std::vector<bool> code = reachable(data, size);
+    for (size_t i = 0; i + 1 < size; i++) {
+        if (!code[i]) continue;
+        uint16_t op = (data[i] << 8) | data[i + 1];
+        uint8_t nn = op & 0xFF;
+        switch (op >> 12) {
+        case 0x0:
+            if ((op & 0xFFF0) == 0x00C0 || op == 0x00FB || op == 0x00FC || op == 0x00FD ||
+                op == 0x00FE || op == 0x00FF) schip = true;
+            if ((op & 0xFFF0) == 0x00D0) xochip = true; // Scroll up
+            break;
+        case 0x5:
+            if ((op & 0xF) == 0x2 || (op & 0xF) == 0x3) xochip = true; // Save/load Vx..Vy
+            break;
+        case 0x8:
+            if ((op & 0xF) >= 0x1 && (op & 0xF) <= 0x3) info.quirks |= QUIRK_VF_RESET;
+            if ((op & 0xF) == 0x6 || (op & 0xF) == 0xE) info.quirks |= QUIRK_SHIFT;
+            break;
+        case 0xB:
+            info.quirks |= QUIRK_JUMP;
+            break;
+        case 0xD:
+            info.quirks |= QUIRK_DISPLAY;
+            if ((op & 0xF) == 0) schip = true; // 16x16 sprite
+            break;
+        case 0xF:
+            if (op == 0xF000 || op == 0xF002 || nn == 0x01 || nn == 0x3A) xochip = true;
+            if (nn == 0x30 || nn == 0x75 || nn == 0x85) schip = true;
+            if (nn == 0x55 || nn == 0x65) info.quirks |= QUIRK_MEMORY;
+            break;
+        }
+    }
+    info.platform = xochip ? Platform::XOChip : schip ? Platform::SChip : Platform::Chip8;
+    return info;
+}
+
+RomIndex::RomIndex(const std::string& path): file(path) {
+    if (file.size() < sizeof(RomIndexHeader)) throw std::runtime_error("Invalid ROM index " + path);
+    RomIndexHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, ROM_INDEX_MAGIC, 4) != 0 || header.version != ROM_INDEX_VERSION ||
+        file.size() != sizeof(header) + header.count * sizeof(RomIndexEntry) + header.names_size) {
+        throw std::runtime_error("Invalid ROM index " + path);
+    }
+    count = header.count;
+    entries = reinterpret_cast<const RomIndexEntry*>(file.data() + sizeof(header));
+    names = reinterpret_cast<const char*>(entries + count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (static_cast<uint64_t>(entries[i].name_offset) + entries[i].name_len > header.names_size) {
+            throw std::runtime_error("Invalid ROM index " + path);
+        }
+    }
+}
+
+const RomIndexEntry* RomIndex::find(uint64_t hash) const {
+    const RomIndexEntry* end = entries + count;
+    const RomIndexEntry* it = std::lower_bound(entries, end, hash,
+        [](const RomIndexEntry& e, uint64_t h) { return e.hash < h; });
+    return (it != end && it->hash == hash) ? it : nullptr;
+}
+
+const RomIndexEntry* RomIndex::find_name(std::string_view path) const {
+    for (uint32_t i = 0; i < count; i++) {
+        if (name(entries[i]) == path) return &entries[i];
+    }
+    return nullptr;
+}
+
+RomIndexStats build_rom_index(const std::vector<std::string>& paths, const std::string& out_path,
+                              const RomIndex* previous) {
+    RomIndexStats stats;
+    std::vector<RomIndexEntry> entries;
+    std::string names;
+    entries.reserve(paths.size());
+
+    // One lookup per path, so find_name's linear scan would make rebuilds quadratic
+    std::unordered_map<std::string_view, const RomIndexEntry*> by_name;
+    if (previous) {
+        by_name.reserve(previous->size());
+        for (size_t i = 0; i < previous->size(); i++) {
+            const RomIndexEntry& e = previous->at(i);
+            by_name.emplace(previous->name(e), &e);
+        }
+    }
+
+    for (const std::string& path : paths) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || path.size() > UINT16_MAX) {
+            stats.skipped++;
+            continue;
+        }
+        RomIndexEntry entry{};
+        auto found = by_name.find(path);
+        const RomIndexEntry* old = found != by_name.end() ? found->second : nullptr;
+        if (old && old->size == static_cast<uint64_t>(st.st_size) && old->mtime == st.st_mtime) {
+            entry = *old;
+            stats.reused++;
+        } else {
+            try {
+                MappedRom rom(path);
+                RomInfo info = analyze_rom(rom.data(), rom.size());
+                entry.hash = info.hash;
+                entry.size = info.size;
+                entry.platform = static_cast<uint8_t>(info.platform);
+                entry.quirks = info.quirks;
+                entry.mtime = st.st_mtime;
+            } catch (const std::runtime_error&) {
+                stats.skipped++;
+                continue;
+            }
+            stats.hashed++;
+        }
+        entry.name_offset = static_cast<uint32_t>(names.size());
+        entry.name_len = static_cast<uint16_t>(path.size());
+        names += path;
+        entries.push_back(entry);
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+        [](const RomIndexEntry& a, const RomIndexEntry& b) { return a.hash < b.hash; });
+
+    RomIndexHeader header;
+    memcpy(header.magic, ROM_INDEX_MAGIC, 4);
+    header.version = ROM_INDEX_VERSION;
+    header.count = static_cast<uint32_t>(entries.size());
+    header.names_size = static_cast<uint32_t>(names.size());
+
+    // Write next to the target and rename, so readers never map a half written index
+    std::string tmp_path = out_path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Failed to open file " + tmp_path);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(RomIndexEntry));
+        out.write(names.data(), names.size());
+        if (!out) throw std::runtime_error("Failed to write file " + tmp_path);
+    }
+    if (std::rename(tmp_path.c_str(), out_path.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace file " + out_path);
+    }
+    return stats;
+}
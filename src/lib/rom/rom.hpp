@@ -0,0 +1,121 @@
+#ifndef SRC_LIB_ROM_HPP
+#define SRC_LIB_ROM_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only memory mapping of a ROM file. Nothing is copied until the bytes are used.
+class MappedRom {
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    explicit MappedRom(const std::string& path);
+    ~MappedRom();
+
+    MappedRom(const MappedRom&) = delete;
+    MappedRom& operator=(const MappedRom&) = delete;
+    MappedRom(MappedRom&& other) noexcept;
+    MappedRom& operator=(MappedRom&& other) noexcept;
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+enum class Platform : uint8_t {
+    Chip8,
+    SChip,  // Uses SUPER-CHIP opcodes (scrolling, hires, big font, flags)
+    XOChip, // Uses XO-CHIP opcodes or needs more than 4 KB
+};
+
+const char* platform_name(Platform platform);
+
+// Instructions whose behaviour differs between interpreters
+enum Quirk : uint8_t {
+    QUIRK_VF_RESET = 1 << 0, // 8xy1/8xy2/8xy3 clear VF
+    QUIRK_MEMORY = 1 << 1,   // Fx55/Fx65 advance I
+    QUIRK_SHIFT = 1 << 2,    // 8xy6/8xyE shift Vy or Vx
+    QUIRK_JUMP = 1 << 3,     // Bnnn adds V0 or Vx
+    QUIRK_DISPLAY = 1 << 4,  // Dxyn waits for vblank and clips or wraps
+};
+
+std::string quirk_names(uint8_t quirks);
+
+struct RomInfo {
+    uint64_t hash = 0;
+    uint32_t size = 0;
+    Platform platform = Platform::Chip8;
+    uint8_t quirks = 0; // Quirk bits of instructions found in the image
+};
+
+// Content hash plus the platform and quirk-sensitive instructions found in code reachable
+// from the entry point. Code only entered through Bnnn jump tables is not seen.
+RomInfo analyze_rom(const uint8_t* data, size_t size);
+
+#define ROM_INDEX_MAGIC "C8IX"
+#define ROM_INDEX_VERSION 1 // Bump when the layout or analyze_rom changes so old entries are not reused
+
+// On-disk index layout: header, entries sorted by hash, then the path string table.
+// Fixed little-endian records so the file can be used in place through mmap.
+struct RomIndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t names_size;
+};
+
+struct RomIndexEntry {
+    uint64_t hash;
+    int64_t mtime; // Seconds, used with size to skip re-hashing unchanged files
+    uint32_t size;
+    uint32_t name_offset;
+    uint16_t name_len;
+    uint8_t platform;
+    uint8_t quirks;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(RomIndexHeader) == 16, "RomIndexHeader must stay 16 bytes");
+static_assert(sizeof(RomIndexEntry) == 32, "RomIndexEntry must stay 32 bytes");
+
+// Read-only view of an index file
+class RomIndex {
+private:
+    MappedRom file;
+    const RomIndexEntry* entries = nullptr;
+    const char* names = nullptr;
+    uint32_t count = 0;
+
+public:
+    // Throws std::runtime_error if the file is missing or not a valid index
+    explicit RomIndex(const std::string& path);
+
+    size_t size() const { return count; }
+    const RomIndexEntry& at(size_t i) const { return entries[i]; }
+    std::string_view name(const RomIndexEntry& entry) const {
+        return std::string_view(names + entry.name_offset, entry.name_len);
+    }
+
+    // First entry with this content hash, or nullptr. Binary search over the mapped file.
+    const RomIndexEntry* find(uint64_t hash) const;
+    // Entry stored under this path, or nullptr. A linear scan.
+    const RomIndexEntry* find_name(std::string_view path) const;
+};
+
+struct RomIndexStats {
+    size_t hashed = 0; // Files read and analysed
+    size_t reused = 0; // Files whose size and mtime matched the previous index
+    size_t skipped = 0; // Unreadable files
+};
+
+// Write an index of `paths` to `out_path`. Entries of `previous` are reused when the
+// file size and modification time are unchanged. The file is replaced atomically.
+RomIndexStats build_rom_index(const std::vector<std::string>& paths, const std::string& out_path,
+                              const RomIndex* previous = nullptr);
+
+#endif
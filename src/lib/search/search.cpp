@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include "search.hpp"
+#include "../utils/format.hpp"
+
+#define SEARCH_SHARDS 64 // Visited set shards, so threads rarely wait on each other
+
+bool parse_strategy(const std::string& name, SearchStrategy& strategy) {
+    if (name == "bfs") strategy = SearchStrategy::Bfs;
+    else if (name == "beam") strategy = SearchStrategy::Beam;
+    else if (name == "mcts") strategy = SearchStrategy::Mcts;
+    else return false;
+    return true;
+}
+
+const char* strategy_name(SearchStrategy strategy) {
+    switch (strategy) {
+        case SearchStrategy::Bfs: return "bfs";
+        case SearchStrategy::Beam: return "beam";
+        case SearchStrategy::Mcts: return "mcts";
+    }
+    return "unknown";
+}
+
+size_t SearchGoal::met(const Chip8& chip8) const {
+    size_t n = 0;
+    for (const Condition& c : registers) n += c.holds(chip8);
+    for (const MemoryCondition& m : memory) n += compare(m.op, chip8.ram()[m.addr & MEM_MASK], m.value);
+    if (match_display) n += chip8.display_hash() == display_hash;
+    return n;
+}
+
+static bool parse_number(const std::string& text, unsigned long long max, unsigned long long& value) {
+    try {
+        size_t used = 0;
+        value = std::stoull(text, &used, 0);
+        return used == text.size() && value <= max;
+    } catch (const std::logic_error&) {
+        return false;
+    }
+}
+
+bool parse_goal_term(const std::string& text, SearchGoal& goal) {
+    std::istringstream in(text);
+    std::string lhs, op, rhs, extra;
+    if (!(in >> lhs >> op)) return false;
+    unsigned long long value;
+    if (lhs == "display") {
+        if (in >> extra || !parse_number(op, UINT64_MAX, value)) return false;
+        goal.match_display = true;
+        goal.display_hash = value;
+        return true;
+    }
+    Compare cmp;
+    if (!(in >> rhs) || in >> extra || !parse_compare(op, cmp)) return false;
+    if (lhs.size() > 2 && lhs.front() == '[' && lhs.back() == ']') {
+        unsigned long long addr;
+        if (!parse_number(lhs.substr(1, lhs.size() - 2), MEM_MASK, addr) || !parse_number(rhs, 0xFF, value)) return false;
+        goal.memory.push_back({static_cast<uint16_t>(addr), cmp, static_cast<uint8_t>(value)});
+        return true;
+    }
+    Condition condition;
+    if (!parse_register(lhs, condition.reg) || !parse_number(rhs, 0xFFFF, value)) return false;
+    condition.active = true;
+    condition.op = cmp;
+    condition.value = static_cast<uint16_t>(value);
+    goal.registers.push_back(condition);
+    return true;
+}
+
+std::string plan_script(const std::vector<uint16_t>& inputs, size_t frames_per_action) {
+    std::string script;
+    uint16_t held = 0;
+    for (size_t i = 0; i <= inputs.size(); i++) {
+        uint16_t keys = i < inputs.size() ? inputs[i] : 0;
+        if (keys == held) continue;
+        if (!script.empty()) script += ',';
+        script += std::to_string(i * frames_per_action) + ":" + hex(keys, 4);
+        held = keys;
+    }
+    return script;
+}
+
+namespace {
+
+// Hashes of every state seen, split into independently locked shards
+class VisitedSet {
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<uint64_t> hashes;
+    };
+    std::unique_ptr<Shard[]> shards{new Shard[SEARCH_SHARDS]};
+
+public:
+    bool insert(uint64_t hash) {
+        Shard& shard = shards[hash % SEARCH_SHARDS];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.hashes.insert(hash).second;
+    }
+};
+
+// Hold `keys` for `frames` frames. False if the machine faulted.
+bool apply(Chip8& chip8, uint16_t keys, size_t frames) {
+    for (size_t f = 0; f < frames && !chip8.finished(); f++) chip8.run_frame(keys);
+    return chip8.fault() == Fault::None;
+}
+
+class Searcher {
+private:
+    struct PathStep {
+        uint32_t parent;
+        uint16_t keys;
+    };
+
+    struct Node {
+        Chip8 machine;
+        uint32_t step; // Index into steps
+        double score;
+    };
+
+    struct Child {
+        Chip8 machine;
+        uint32_t parent;
+        uint16_t keys;
+        double score;
+    };
+
+    struct TreeNode {
+        Chip8 machine;
+        int parent;
+        uint16_t keys;
+        size_t depth;
+        size_t tried = 0;
+        std::vector<int> children{};
+        size_t visits = 0;
+        double total = 0;
+    };
+
+    const SearchGoal& goal;
+    const SearchOptions& options;
+    std::vector<uint16_t> actions;
+    unsigned n_threads;
+
+    std::atomic<size_t> expanded{0};
+    std::atomic<size_t> unique{0};
+    std::atomic<bool> stop{false};
+    std::mutex result_mutex; // Guards everything below
+    bool found = false;
+    std::vector<uint16_t> plan;
+    double best_score = -1;
+    std::vector<uint16_t> best_plan;
+    size_t depth = 0;
+
+    // Higher is better, in [0, 1]
+    double score(const Chip8& chip8) const {
+        double terms = goal.terms() ? static_cast<double>(goal.met(chip8)) / goal.terms() : 0;
+        if (options.score_addr < 0) return terms;
+        return (chip8.ram()[options.score_addr & MEM_MASK] / 255.0 + terms) / 2;
+    }
+
+    bool over_budget() const {
+        return stop.load(std::memory_order_relaxed) || expanded.load(std::memory_order_relaxed) >= options.max_states;
+    }
+
+    void finish(const std::vector<uint16_t>& inputs) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        if (found) return;
+        found = true;
+        plan = inputs;
+        stop = true;
+    }
+
+    // Compares under the lock, and only builds the inputs for a new best
+    template <typename MakePlan>
+    void offer_best(double s, MakePlan make_plan) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        if (s <= best_score) return;
+        best_score = s;
+        best_plan = make_plan();
+    }
+
+    static std::vector<uint16_t> path(const std::vector<PathStep>& steps, uint32_t step) {
+        std::vector<uint16_t> inputs;
+        for (; step != 0; step = steps[step].parent) inputs.push_back(steps[step].keys);
+        std::reverse(inputs.begin(), inputs.end());
+        return inputs;
+    }
+
+    // Level by level. Each thread expands a stride of the frontier into its own list of
+    // children; the lists are then numbered into the shared path arena.
+    void breadth_first(const Chip8& start, bool beam) {
+        VisitedSet visited;
+        visited.insert(start.state_hash());
+        std::vector<PathStep> steps = {{0, 0}};
+        std::vector<Node> frontier;
+        frontier.push_back({start, 0, score(start)});
+
+        for (size_t level = 0; level < options.max_depth && !frontier.empty() && !over_budget(); level++) {
+            std::vector<std::vector<Child>> children(n_threads);
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < n_threads; t++) {
+                workers.emplace_back([&, t] {
+                    for (size_t i = t; i < frontier.size() && !over_budget(); i += n_threads) {
+                        for (uint16_t keys : actions) {
+                            Chip8 child = frontier[i].machine;
+                            expanded.fetch_add(1, std::memory_order_relaxed);
+                            if (!apply(child, keys, options.frames_per_action)) continue;
+                            if (!visited.insert(child.state_hash())) continue;
+                            unique.fetch_add(1, std::memory_order_relaxed);
+                            if (goal.reached(child)) {
+                                std::vector<uint16_t> inputs = path(steps, frontier[i].step);
+                                inputs.push_back(keys);
+                                finish(inputs);
+                                return;
+                            }
+                            double s = score(child);
+                            children[t].push_back({std::move(child), frontier[i].step, keys, s});
+                        }
+                    }
+                });
+            }
+            for (std::thread& w : workers) w.join();
+            depth = level + 1;
+            if (found) return;
+
+            std::vector<Node> next;
+            for (std::vector<Child>& list : children) {
+                for (Child& c : list) {
+                    steps.push_back({c.parent, c.keys});
+                    next.push_back({std::move(c.machine), static_cast<uint32_t>(steps.size() - 1), c.score});
+                }
+            }
+            if (beam && next.size() > options.beam_width) {
+                std::partial_sort(next.begin(), next.begin() + options.beam_width, next.end(),
+                    [](const Node& a, const Node& b) { return a.score > b.score; });
+                next.resize(options.beam_width);
+            }
+            for (const Node& n : next) {
+                offer_best(n.score, [&] { return path(steps, n.step); });
+            }
+            frontier = std::move(next);
+        }
+    }
+
+    // One UCT tree per thread from the same root, each with its own transposition set
+    void tree_search(const Chip8& start, unsigned thread) {
+        std::mt19937_64 rng(options.seed + thread);
+        std::vector<TreeNode> tree;
+        tree.push_back({start, -1, 0, 0});
+        std::unordered_set<uint64_t> seen = {start.state_hash()};
+        size_t iterations = (options.iterations + n_threads - 1) / n_threads;
+
+        auto tree_path = [&](int node) {
+            std::vector<uint16_t> inputs;
+            for (; node > 0; node = tree[node].parent) inputs.push_back(tree[node].keys);
+            std::reverse(inputs.begin(), inputs.end());
+            return inputs;
+        };
+
+        for (size_t it = 0; it < iterations && !over_budget(); it++) {
+            int node = 0;
+            while (tree[node].tried == actions.size() && !tree[node].children.empty()) {
+                const TreeNode& parent = tree[node];
+                double log_visits = std::log(static_cast<double>(parent.visits));
+                int best = parent.children[0];
+                double best_uct = -1;
+                for (int c : parent.children) {
+                    const TreeNode& child = tree[c];
+                    double uct = child.visits == 0 ? 1e9
+                        : child.total / child.visits + SEARCH_MCTS_EXPLORE * std::sqrt(log_visits / child.visits);
+                    if (uct > best_uct) {
+                        best_uct = uct;
+                        best = c;
+                    }
+                }
+                node = best;
+            }
+
+            // Expand one untried input that leads somewhere new
+            while (tree[node].tried < actions.size() && tree[node].depth < options.max_depth) {
+                uint16_t keys = actions[tree[node].tried++];
+                Chip8 child = tree[node].machine;
+                expanded.fetch_add(1, std::memory_order_relaxed);
+                if (!apply(child, keys, options.frames_per_action) || !seen.insert(child.state_hash()).second) continue;
+                unique.fetch_add(1, std::memory_order_relaxed);
+                size_t child_depth = tree[node].depth + 1;
+                tree.push_back({std::move(child), node, keys, child_depth});
+                tree[node].children.push_back(static_cast<int>(tree.size() - 1));
+                node = static_cast<int>(tree.size() - 1);
+                if (goal.reached(tree[node].machine)) {
+                    finish(tree_path(node));
+                    return;
+                }
+                break;
+            }
+
+            // Random rollout to the depth limit
+            Chip8 sim = tree[node].machine;
+            std::vector<uint16_t> rollout;
+            bool alive = true;
+            for (size_t d = tree[node].depth; d < options.max_depth && alive && !sim.finished(); d++) {
+                uint16_t keys = actions[rng() % actions.size()];
+                expanded.fetch_add(1, std::memory_order_relaxed);
+                alive = apply(sim, keys, options.frames_per_action);
+                rollout.push_back(keys);
+                if (alive && goal.reached(sim)) {
+                    std::vector<uint16_t> inputs = tree_path(node);
+                    inputs.insert(inputs.end(), rollout.begin(), rollout.end());
+                    finish(inputs);
+                    return;
+                }
+            }
+            double reward = alive ? score(sim) : 0;
+            offer_best(reward, [&] {
+                std::vector<uint16_t> inputs = tree_path(node);
+                inputs.insert(inputs.end(), rollout.begin(), rollout.end());
+                return inputs;
+            });
+            for (int n = node; n >= 0; n = tree[n].parent) {
+                tree[n].visits++;
+                tree[n].total += reward;
+            }
+            std::lock_guard<std::mutex> lock(result_mutex);
+            depth = std::max(depth, tree[node].depth);
+        }
+    }
+
+public:
+    Searcher(const SearchGoal& goal, const SearchOptions& options): goal(goal), options(options) {
+        actions = options.actions;
+        if (actions.empty()) {
+            actions.push_back(0);
+            for (int key = 0; key < 16; key++) actions.push_back(1 << key);
+        }
+        n_threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    SearchResult run(const Chip8& start) {
+        auto begin = std::chrono::steady_clock::now();
+        if (goal.reached(start)) {
+            found = true;
+        } else if (options.strategy == SearchStrategy::Mcts) {
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < n_threads; t++) workers.emplace_back([&, t] { tree_search(start, t); });
+            for (std::thread& w : workers) w.join();
+        } else {
+            breadth_first(start, options.strategy == SearchStrategy::Beam);
+        }
+
+        SearchResult result;
+        result.found = found;
+        result.inputs = found ? plan : best_plan;
+        result.expanded = expanded;
+        result.unique = unique;
+        result.depth = depth;
+        result.threads = n_threads;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        return result;
+    }
+};
+
+}
+
+SearchResult search(const Chip8& start, const SearchGoal& goal, const SearchOptions& options) {
+    Searcher searcher(goal, options);
+    return searcher.run(start);
+}
@@ -0,0 +1,79 @@
+#ifndef SRC_LIB_SEARCH_HPP
+#define SRC_LIB_SEARCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../chip8/chip8.hpp"
+#include "../debug/debugger.hpp"
+
+#define SEARCH_MAX_DEPTH 32         // Default number of inputs in a plan
+#define SEARCH_MAX_STATES 2000000   // Default budget of expanded states
+#define SEARCH_BEAM_WIDTH 512       // States kept per depth by beam search
+#define SEARCH_MCTS_ITERATIONS 20000 // Tree iterations, shared by all threads
+#define SEARCH_MCTS_EXPLORE 1.4     // UCT exploration constant
+
+enum class SearchStrategy {
+    Bfs,  // Breadth first: finds a shortest input sequence, dedups every state
+    Beam, // Breadth first, keeping only the best scoring states at each depth
+    Mcts, // Monte Carlo tree search with random rollouts, one tree per thread
+};
+
+bool parse_strategy(const std::string& name, SearchStrategy& strategy);
+const char* strategy_name(SearchStrategy strategy);
+
+struct MemoryCondition {
+    uint16_t addr;
+    Compare op;
+    uint8_t value;
+};
+
+// The screen or machine state a plan has to reach; every term must hold
+struct SearchGoal {
+    std::vector<Condition> registers;
+    std::vector<MemoryCondition> memory;
+    bool match_display = false;
+    uint64_t display_hash = 0;
+
+    size_t terms() const { return registers.size() + memory.size() + match_display; }
+    size_t met(const Chip8& chip8) const;
+    bool reached(const Chip8& chip8) const { return met(chip8) == terms(); }
+};
+
+// "V3 == 5", "[0x300] >= 2" or "display 0x4869a244aa76d9ad", added to `goal`
+bool parse_goal_term(const std::string& text, SearchGoal& goal);
+
+struct SearchOptions {
+    SearchStrategy strategy = SearchStrategy::Bfs;
+    std::vector<uint16_t> actions; // Keydown masks tried at every step; empty = none and each single key
+    size_t frames_per_action = 1;  // Frames each input is held
+    size_t max_depth = SEARCH_MAX_DEPTH;
+    size_t max_states = SEARCH_MAX_STATES;
+    size_t beam_width = SEARCH_BEAM_WIDTH;
+    size_t iterations = SEARCH_MCTS_ITERATIONS;
+    int score_addr = -1; // Memory byte to maximise in beam and MCTS; otherwise goal terms met
+    unsigned threads = 0; // 0 = every core
+    uint64_t seed = 1;
+};
+
+struct SearchResult {
+    bool found = false;
+    std::vector<uint16_t> inputs; // One keydown mask per step, held frames_per_action frames
+    size_t expanded = 0;          // States stepped from a parent
+    size_t unique = 0;            // Of those, states not seen before
+    size_t depth = 0;             // Deepest level reached
+    double seconds = 0;
+    unsigned threads = 0;
+
+    double states_per_second() const { return seconds > 0 ? expanded / seconds : 0; }
+};
+
+// Search for inputs that take `start` to `goal`. When the goal is not reached, `inputs`
+// holds the best scoring plan found. Machines are forked by copy and stepped headless.
+SearchResult search(const Chip8& start, const SearchGoal& goal, const SearchOptions& options);
+
+// The plan as an InputScript ("frame:mask,..."), replayable with headless --keys
+std::string plan_script(const std::vector<uint16_t>& inputs, size_t frames_per_action);
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef SRC_UI_AUDIO_HPP
+#define SRC_UI_AUDIO_HPP
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include "../chip8/chip8.hpp"
+
+#define AUDIO_SAMPLE_RATE 48000
+#define AUDIO_RING_SIZE 8192 // Must be a power of two
+#define AUDIO_LATENCY 1600 // Samples queued ahead of the device (~33ms)
+#define AUDIO_AMPLITUDE 3000
+#define BEEP_FREQ 440
+
+// Single producer / single consumer sample ring between the emulator thread and the
+// SDL audio thread. Everything is allocated up front so the audio thread never allocates.
+class Beeper {
+private:
+    static constexpr int square_period = AUDIO_SAMPLE_RATE / BEEP_FREQ;
+
+    std::array<int16_t, AUDIO_RING_SIZE> ring{};
+    std::atomic<size_t> head{0}; // Next slot written by the producer
+    std::atomic<size_t> tail{0}; // Next slot read by the audio thread
+    std::atomic<size_t> n_underruns{0};
+
+    // Precomputed waveforms
+    std::array<int16_t, square_period> square{};
+    std::array<int16_t, 128> pattern{}; // XO-CHIP pattern, one sample per bit
+    std::array<uint32_t, 256> pitch_step{}; // 16.16 pattern bits advanced per output sample
+    uint32_t pattern_gen = 0;
+
+    uint32_t phase = 0;
+    uint64_t last_ns = 0;
+    uint64_t frac = 0; // Sub-sample remainder carried between feeds, in ns * sample rate
+    size_t last_tick = 0;  // Machine instructions at the end of the previous feed
+    size_t next_edge = 0;  // First Chip8::sound_edge not yet played
+    bool gate = false;     // Whether the beep was on at last_tick
+
+    void load_pattern(const uint8_t* bytes) {
+        for (int i = 0; i < 128; i++) {
+            bool bit = bytes[i >> 3] & (0x80 >> (i & 7));
+            pattern[i] = bit ? AUDIO_AMPLITUDE : -AUDIO_AMPLITUDE;
+        }
+    }
+
+public:
+    Beeper() {
+        for (int i = 0; i < square_period; i++) {
+            square[i] = (i < square_period / 2) ? AUDIO_AMPLITUDE : -AUDIO_AMPLITUDE;
+        }
+        // XO-CHIP plays the pattern at 4000 * 2^((pitch - 64) / 48) bits per second
+        for (int p = 0; p < 256; p++) {
+            double rate = 4000.0 * std::pow(2.0, (p - 64) / 48.0);
+            pitch_step[p] = static_cast<uint32_t>(rate / AUDIO_SAMPLE_RATE * 65536.0);
+        }
+        // Prime the ring with silence so the first callbacks have something to play
+        head.store(AUDIO_LATENCY, std::memory_order_release);
+    }
+
+    // Producer side: synthesise the samples elapsed since the last call. The instructions
+    // run since then are spread evenly over those samples, and each sample is gated by the
+    // sound timer as it stood at its instruction, from the machine's log of beep edges.
+    // Never writes more than the ring can hold. `mute` writes silence instead, for when the
+    // machine runs faster than real time.
+    void feed(const Chip8& chip8, uint64_t now_ns, bool mute = false) {
+        if (last_ns == 0) last_ns = now_ns;
+        frac += (now_ns - last_ns) * AUDIO_SAMPLE_RATE;
+        last_ns = now_ns;
+        size_t n = frac / 1000000000ull;
+        frac %= 1000000000ull;
+
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t queued = h - tail.load(std::memory_order_acquire);
+        if (queued + n > AUDIO_LATENCY) n = queued < AUDIO_LATENCY ? AUDIO_LATENCY - queued : 0;
+
+        if (chip8.audio_pattern_gen() != pattern_gen) {
+            pattern_gen = chip8.audio_pattern_gen();
+            load_pattern(chip8.audio_pattern());
+        }
+
+        const size_t ticks = chip8.ticks();
+        const size_t edges = chip8.sound_edges();
+        if (ticks < last_tick || edges < next_edge) { // The machine was reset
+            last_tick = 0;
+            next_edge = 0;
+            gate = false;
+        }
+        if (edges - next_edge > SOUND_EDGES) { // Older edges were overwritten; start from now
+            next_edge = edges;
+            gate = chip8.is_beeping();
+        }
+        const uint32_t step = pitch_step[chip8.audio_pitch()];
+        for (size_t i = 0; i < n; i++) {
+            const size_t at = last_tick + (ticks - last_tick) * i / n;
+            while (next_edge < edges && chip8.sound_edge(next_edge).tick <= at) gate = chip8.sound_edge(next_edge++).on;
+            int16_t sample = 0;
+            if (mute || !gate) {
+                phase = 0;
+            } else if (pattern_gen == 0) {
+                sample = square[phase];
+                if (++phase == square_period) phase = 0;
+            } else {
+                sample = pattern[phase >> 16];
+                phase = (phase + step) & ((128u << 16) - 1);
+            }
+            ring[(h + i) & (AUDIO_RING_SIZE - 1)] = sample;
+        }
+        // Edges after the last sample carry over as the state at the next feed's start
+        next_edge = edges;
+        gate = chip8.is_beeping();
+        last_tick = ticks;
+        head.store(h + n, std::memory_order_release);
+    }
+
+    // Consumer side: copy n samples out, padding with silence if the producer fell behind.
+    void drain(int16_t* out, size_t n) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t available = head.load(std::memory_order_acquire) - t;
+        size_t n_copy = available < n ? available : n;
+        for (size_t i = 0; i < n_copy; i++) out[i] = ring[(t + i) & (AUDIO_RING_SIZE - 1)];
+        for (size_t i = n_copy; i < n; i++) out[i] = 0;
+        if (n_copy < n) n_underruns.fetch_add(1, std::memory_order_relaxed);
+        tail.store(t + n_copy, std::memory_order_release);
+    }
+
+    size_t underruns() const { return n_underruns.load(std::memory_order_relaxed); }
+};
+
+#endif
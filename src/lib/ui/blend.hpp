@@ -0,0 +1,71 @@
+#ifndef SRC_UI_BLEND_HPP
+#define SRC_UI_BLEND_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "../chip8/chip8.hpp"
+
+enum class Blend {
+    Off,   // Show the live display
+    Or,    // Pixel is lit if it was lit in either of the last two frames
+    Decay, // Pixels lit only in the previous frame are drawn at half intensity
+};
+
+inline bool parse_blend(const std::string& name, Blend& blend) {
+    if (name == "off") blend = Blend::Off;
+    else if (name == "or") blend = Blend::Or;
+    else if (name == "decay") blend = Blend::Decay;
+    else return false;
+    return true;
+}
+
+inline const char* blend_name(Blend blend) {
+    switch (blend) {
+        case Blend::Off: return "off";
+        case Blend::Or: return "or";
+        case Blend::Decay: return "decay";
+    }
+    return "unknown";
+}
+
+// Keeps the last two completed frames as packed bitplanes (256 bytes each) and
+// combines them at presentation time, so XOR-drawn sprites stop flickering.
+class FrameBlender {
+private:
+    uint64_t ring[2][DISPLAY_HEIGHT]{};
+    int newest = 0;
+    size_t last_frame = static_cast<size_t>(-1);
+    uint64_t lit[DISPLAY_HEIGHT]{};
+    uint64_t ghost[DISPLAY_HEIGHT]{};
+
+public:
+    Blend mode = Blend::Off;
+
+    // Record the display once per emulated frame
+    void capture(const Chip8& chip8) {
+        size_t frame = chip8.frame_count();
+        if (frame == last_frame) return;
+        last_frame = frame;
+        newest ^= 1;
+        memcpy(ring[newest], chip8.display_rows(), sizeof(ring[newest]));
+    }
+
+    // Rows to draw fully lit; `ghost_rows` is set to the half intensity rows or nullptr
+    const uint64_t* compose(const Chip8& chip8, const uint64_t*& ghost_rows) {
+        ghost_rows = nullptr;
+        if (mode == Blend::Off) return chip8.display_rows();
+
+        const uint64_t* cur = ring[newest];
+        const uint64_t* prev = ring[newest ^ 1];
+        if (mode == Blend::Or) {
+            for (int y = 0; y < DISPLAY_HEIGHT; y++) lit[y] = cur[y] | prev[y];
+            return lit;
+        }
+        for (int y = 0; y < DISPLAY_HEIGHT; y++) ghost[y] = prev[y] & ~cur[y];
+        ghost_rows = ghost;
+        return cur;
+    }
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SRC_UI_METRICS_HPP
+#define SRC_UI_METRICS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#define METRICS_WINDOW_NS 500000000ull // Rates are averaged over half a second
+
+// Emulated frames and instructions per second of wall time, and the speed multiple that
+// gives against the machine's native frame rate. SDL free; the UI feeds it timestamps.
+class SpeedMeter {
+private:
+    uint64_t start_ns = 0;
+    size_t start_frame = 0;
+    size_t start_ticks = 0;
+    double fps_ = 0;
+    double ips_ = 0;
+
+public:
+    // Call with the machine's frame_count() and ticks() as often as convenient
+    void update(uint64_t now_ns, size_t frames, size_t ticks) {
+        if (start_ns == 0 || frames < start_frame || ticks < start_ticks) {
+            // First sample, or the machine was reset
+            start_ns = now_ns;
+            start_frame = frames;
+            start_ticks = ticks;
+            return;
+        }
+        uint64_t elapsed = now_ns - start_ns;
+        if (elapsed < METRICS_WINDOW_NS) return;
+        fps_ = (frames - start_frame) * 1e9 / elapsed;
+        ips_ = (ticks - start_ticks) * 1e9 / elapsed;
+        start_ns = now_ns;
+        start_frame = frames;
+        start_ticks = ticks;
+    }
+
+    double fps() const { return fps_; }
+    double ips() const { return ips_; }
+    double speed(int native_fps) const { return fps_ / native_fps; }
+
+    // One line for the overlay, e.g. "TURBO 12.3x 615 fps 12300 ips"
+    std::string describe(int native_fps, bool turbo) const {
+        char line[64];
+        snprintf(line, sizeof(line), "%s%.1fx %.0f fps %.0f ips", turbo ? "TURBO " : "", speed(native_fps), fps_, ips_);
+        return line;
+    }
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include <cstring>
+#include <algorithm>
+#include "scaler.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define LINE_PAD 4 // Vector stores may spill up to 3 pixels past the last one
+#define PHOSPHOR_GHOST 128   // Lowest level of a ghosted pixel
+#define PHOSPHOR_MAX_DECAY 20 // Decay steps that take any level to 0
+
+bool parse_filter(const std::string& name, Filter& filter) {
+    if (name == "nearest") filter = Filter::Nearest;
+    else if (name == "scanline") filter = Filter::Scanline;
+    else if (name == "grid") filter = Filter::PixelGrid;
+    else if (name == "phosphor") filter = Filter::Phosphor;
+    else return false;
+    return true;
+}
+
+const char* filter_name(Filter filter) {
+    switch (filter) {
+        case Filter::Nearest: return "nearest";
+        case Filter::Scanline: return "scanline";
+        case Filter::PixelGrid: return "grid";
+        case Filter::Phosphor: return "phosphor";
+    }
+    return "unknown";
+}
+
+// Halve every colour channel, keeping alpha opaque
+static inline uint32_t dim(uint32_t c) {
+    return ((c >> 1) & 0x7F7F7F7Fu) | 0xFF000000u;
+}
+
+// Pick COLOR_ON / COLOR_GHOST / COLOR_OFF for each of the 64 pixels in a packed row
+static void bits_to_colors(uint64_t bits, uint64_t ghost, uint32_t* out) {
+#if defined(__SSE2__)
+    const __m128i select = _mm_set_epi32(1, 2, 4, 8);
+    const __m128i on = _mm_set1_epi32(static_cast<int>(COLOR_ON));
+    const __m128i half = _mm_set1_epi32(static_cast<int>(COLOR_GHOST));
+    const __m128i off = _mm_set1_epi32(static_cast<int>(COLOR_OFF));
+    for (int x = 0; x < DISPLAY_WIDTH; x += 4) {
+        int shift = 60 - x;
+        __m128i lit = _mm_set1_epi32(static_cast<int>((bits >> shift) & 0xF));
+        __m128i half_lit = _mm_set1_epi32(static_cast<int>((ghost >> shift) & 0xF));
+        __m128i lit_mask = _mm_cmpeq_epi32(_mm_and_si128(lit, select), select);
+        __m128i dim_mask = _mm_cmpeq_epi32(_mm_and_si128(half_lit, select), select);
+        __m128i rest = _mm_or_si128(_mm_and_si128(dim_mask, half), _mm_andnot_si128(dim_mask, off));
+        __m128i px = _mm_or_si128(_mm_and_si128(lit_mask, on), _mm_andnot_si128(lit_mask, rest));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), px);
+    }
+#elif defined(__ARM_NEON)
+    const uint32x4_t select = {8, 4, 2, 1};
+    const uint32x4_t on = vdupq_n_u32(COLOR_ON);
+    const uint32x4_t half = vdupq_n_u32(COLOR_GHOST);
+    const uint32x4_t off = vdupq_n_u32(COLOR_OFF);
+    for (int x = 0; x < DISPLAY_WIDTH; x += 4) {
+        int shift = 60 - x;
+        uint32x4_t lit_mask = vtstq_u32(vdupq_n_u32(static_cast<uint32_t>((bits >> shift) & 0xF)), select);
+        uint32x4_t dim_mask = vtstq_u32(vdupq_n_u32(static_cast<uint32_t>((ghost >> shift) & 0xF)), select);
+        vst1q_u32(out + x, vbslq_u32(lit_mask, on, vbslq_u32(dim_mask, half, off)));
+    }
+#else
+    for (int x = 0; x < DISPLAY_WIDTH; x++) {
+        uint64_t bit = 0x8000000000000000ull >> x;
+        out[x] = (bits & bit) ? COLOR_ON : (ghost & bit) ? COLOR_GHOST : COLOR_OFF;
+    }
+#endif
+}
+
+// Phosphor levels for one row: lit pixels jump to full brightness, unlit ones decay to 3/4
+// once per emulated frame but never below PHOSPHOR_GHOST while they are ghosted. Writes
+// the grey colour of every level.
+static void phosphor_row(uint64_t bits, uint64_t ghost, int decays, uint8_t* level, uint32_t* out) {
+#if defined(__SSE2__)
+    const __m128i select = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i three = _mm_set1_epi16(3);
+    const __m128i ghost_level = _mm_set1_epi8(static_cast<char>(PHOSPHOR_GHOST));
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    // One byte per pixel, 16 pixels: the row's bits for them, set where selected
+    auto mask = [&](uint64_t row, int x) {
+        uint64_t hi = (row >> (56 - x)) & 0xFF, lo = (row >> (48 - x)) & 0xFF;
+        __m128i bytes = _mm_set_epi64x(static_cast<long long>(lo * 0x0101010101010101ull),
+                                       static_cast<long long>(hi * 0x0101010101010101ull));
+        return _mm_cmpeq_epi8(_mm_and_si128(bytes, select), select);
+    };
+    for (int x = 0; x < DISPLAY_WIDTH; x += 16) {
+        __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(level + x));
+        for (int d = 0; d < decays; d++) {
+            __m128i lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(l, zero), three), 2);
+            __m128i hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(l, zero), three), 2);
+            l = _mm_packus_epi16(lo, hi);
+        }
+        l = _mm_max_epu8(l, _mm_and_si128(mask(ghost, x), ghost_level));
+        l = _mm_or_si128(l, mask(bits, x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(level + x), l);
+        const __m128i words[2] = {_mm_unpacklo_epi8(l, zero), _mm_unpackhi_epi8(l, zero)};
+        for (int i = 0; i < 4; i++) {
+            __m128i c = i & 1 ? _mm_unpackhi_epi16(words[i >> 1], zero) : _mm_unpacklo_epi16(words[i >> 1], zero);
+            c = _mm_or_si128(_mm_or_si128(c, _mm_slli_epi32(c, 8)), _mm_or_si128(_mm_slli_epi32(c, 16), alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + i * 4), c);
+        }
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t select = {128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1};
+    const uint8x8_t three = vdup_n_u8(3);
+    const uint32x4_t alpha = vdupq_n_u32(0xFF000000u);
+    auto mask = [&](uint64_t row, int x) {
+        uint8x16_t bytes = vcombine_u8(vdup_n_u8(static_cast<uint8_t>(row >> (56 - x))),
+                                       vdup_n_u8(static_cast<uint8_t>(row >> (48 - x))));
+        return vtstq_u8(bytes, select);
+    };
+    for (int x = 0; x < DISPLAY_WIDTH; x += 16) {
+        uint8x16_t l = vld1q_u8(level + x);
+        for (int d = 0; d < decays; d++) {
+            l = vcombine_u8(vshrn_n_u16(vmull_u8(vget_low_u8(l), three), 2),
+                            vshrn_n_u16(vmull_u8(vget_high_u8(l), three), 2));
+        }
+        l = vmaxq_u8(l, vandq_u8(mask(ghost, x), vdupq_n_u8(PHOSPHOR_GHOST)));
+        l = vorrq_u8(l, mask(bits, x));
+        vst1q_u8(level + x, l);
+        const uint16x8_t words[2] = {vmovl_u8(vget_low_u8(l)), vmovl_u8(vget_high_u8(l))};
+        for (int i = 0; i < 4; i++) {
+            uint32x4_t c = vmovl_u16(i & 1 ? vget_high_u16(words[i >> 1]) : vget_low_u16(words[i >> 1]));
+            c = vorrq_u32(vorrq_u32(c, vshlq_n_u32(c, 8)), vorrq_u32(vshlq_n_u32(c, 16), alpha));
+            vst1q_u32(out + x + i * 4, c);
+        }
+    }
+#else
+    for (int x = 0; x < DISPLAY_WIDTH; x++) {
+        uint64_t bit = 0x8000000000000000ull >> x;
+        uint8_t decayed = level[x];
+        for (int d = 0; d < decays; d++) decayed = static_cast<uint8_t>((decayed * 3) >> 2);
+        if (ghost & bit) decayed = std::max<uint8_t>(decayed, PHOSPHOR_GHOST);
+        level[x] = (bits & bit) ? 255 : decayed;
+        uint32_t c = level[x];
+        out[x] = 0xFF000000u | (c << 16) | (c << 8) | c;
+    }
+#endif
+}
+
+// Repeat every native pixel `scale` times horizontally
+static void expand(const uint32_t* colors, uint32_t* line, int scale) {
+    if (scale == 1) {
+        memcpy(line, colors, DISPLAY_WIDTH * sizeof(uint32_t));
+        return;
+    }
+    for (int x = 0; x < DISPLAY_WIDTH; x++) {
+        uint32_t* dst = line + x * scale;
+#if defined(__SSE2__)
+        __m128i px = _mm_set1_epi32(static_cast<int>(colors[x]));
+        for (int i = 0; i < scale; i += 4) _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), px);
+#elif defined(__ARM_NEON)
+        uint32x4_t px = vdupq_n_u32(colors[x]);
+        for (int i = 0; i < scale; i += 4) vst1q_u32(dst + i, px);
+#else
+        std::fill_n(dst, scale, colors[x]);
+#endif
+    }
+}
+
+static void dim_span(const uint32_t* src, uint32_t* dst, int n) {
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i chan = _mm_set1_epi32(0x7F7F7F7F);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        px = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(px, 1), chan), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), px);
+    }
+#elif defined(__ARM_NEON)
+    const uint32x4_t chan = vdupq_n_u32(0x7F7F7F7Fu);
+    const uint32x4_t alpha = vdupq_n_u32(0xFF000000u);
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t px = vld1q_u32(src + i);
+        vst1q_u32(dst + i, vorrq_u32(vandq_u32(vshrq_n_u32(px, 1), chan), alpha));
+    }
+#endif
+    for (; i < n; i++) dst[i] = dim(src[i]);
+}
+
+Scaler::Scaler(int scale, Filter filter) : scale(std::max(scale, 1)), filter(filter) {
+    colors.resize(DISPLAY_WIDTH + LINE_PAD);
+    line.resize(width() + LINE_PAD);
+    dim_line.resize(width() + LINE_PAD);
+    intensity.assign(DISPLAY_WIDTH * DISPLAY_HEIGHT, 0);
+}
+
+void Scaler::set_filter(Filter f) {
+    if (f == Filter::Phosphor && filter != Filter::Phosphor) {
+        std::fill(intensity.begin(), intensity.end(), 0);
+    }
+    filter = f;
+}
+
+void Scaler::render(const uint64_t* rows, uint32_t* out, int pitch, const uint64_t* ghost, size_t frames) {
+    const int w = width();
+    const int decays = static_cast<int>(std::min<size_t>(frames, PHOSPHOR_MAX_DECAY));
+    const bool dim_last_line = scale >= 2 && (filter == Filter::Scanline || filter == Filter::PixelGrid);
+    char* dst = reinterpret_cast<char*>(out);
+
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        if (filter == Filter::Phosphor) {
+            phosphor_row(rows[y], ghost ? ghost[y] : 0, decays, intensity.data() + y * DISPLAY_WIDTH, colors.data());
+        } else {
+            bits_to_colors(rows[y], ghost ? ghost[y] : 0, colors.data());
+        }
+
+        expand(colors.data(), line.data(), scale);
+        if (dim_last_line) dim_span(line.data(), dim_line.data(), w);
+        if (filter == Filter::PixelGrid && scale >= 2) {
+            for (int x = scale - 1; x < w; x += scale) line[x] = dim_line[x];
+        }
+
+        for (int s = 0; s < scale; s++, dst += pitch) {
+            const uint32_t* src = (dim_last_line && s == scale - 1) ? dim_line.data() : line.data();
+            memcpy(dst, src, w * sizeof(uint32_t));
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef SRC_UI_SCALER_HPP
+#define SRC_UI_SCALER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../chip8/chip8.hpp"
+
+#define COLOR_ON 0xFFFFFFFFu
+#define COLOR_OFF 0xFF000000u
+#define COLOR_GHOST 0xFF808080u
+
+enum class Filter {
+    Nearest,   // Plain integer upscale
+    Scanline,  // Darken the last line of every scaled row
+    PixelGrid, // Darken the last line and column of every scaled pixel
+    Phosphor,  // Lit pixels fade out over a few frames instead of vanishing
+};
+
+bool parse_filter(const std::string& name, Filter& filter);
+const char* filter_name(Filter filter);
+
+// Expands the packed 64x32 display into a 32-bit texture at an integer scale. SDL free
+// so the kernels can be driven by benchmarks and headless tools.
+class Scaler {
+private:
+    int scale;
+    Filter filter;
+    std::vector<uint32_t> colors; // One colour per native pixel of the current row
+    std::vector<uint32_t> line; // Expanded row, padded for vector stores
+    std::vector<uint32_t> dim_line; // Expanded row with the filter's darkening applied
+    std::vector<uint8_t> intensity; // Phosphor level per native pixel
+
+public:
+    Scaler(int scale, Filter filter);
+
+    int width() const { return DISPLAY_WIDTH * scale; }
+    int height() const { return DISPLAY_HEIGHT * scale; }
+    Filter get_filter() const { return filter; }
+    void set_filter(Filter f);
+
+    // Render one frame, `pitch` is the destination row stride in bytes. Pixels set in the
+    // optional `ghost` rows but not in `rows` are drawn at half intensity. `frames` is the
+    // number of emulated frames since the previous render, which Phosphor fades by, so
+    // persistence does not depend on how often frames are presented.
+    void render(const uint64_t* rows, uint32_t* out, int pitch, const uint64_t* ghost = nullptr, size_t frames = 1);
+};
+
+#endif
@@ -6,12 +6,24 @@
 #include <vector>
 #include <cstdint>
 #include <optional>
+#include <array>
+#include <algorithm>
 #include <iostream>
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 #include "../chip8/chip8.hpp"
+#include "audio.hpp"
+#include "scaler.hpp"
+#include "blend.hpp"
+#include "metrics.hpp"
+#include "../capture/capture.hpp"
+#include "../asm/source_map.hpp"
+#include "../debug/console.hpp"
+#include "../utils/format.hpp"
 #include <unordered_map>
 
+#define TURBO_SLICE_NS 4000000ull // Turbo emulates this long between polls for input
+
 const std::unordered_map<uint8_t, uint8_t> key_map = {
     {SDLK_X, 0x0}, {SDLK_1, 0x1}, {SDLK_2, 0x2}, {SDLK_3, 0x3},
     {SDLK_Q, 0x4}, {SDLK_W, 0x5}, {SDLK_E, 0x6}, {SDLK_A, 0x7},
@@ -24,7 +36,12 @@ private:
     struct PrivateTag {};
     static std::optional<UI> instance;
     
-    std::vector<uint32_t> frame_buffer;
+    Scaler scaler;
+    FrameBlender blender;
+    Capture* capture = nullptr;
+    const SourceMap* source_map = nullptr;
+    Debugger debugger;
+    size_t captured_frame = 0;
     SDL_Window* sdl_window = nullptr;
     SDL_Renderer* sdl_renderer = nullptr;
     SDL_Texture* sdl_texture = nullptr;
@@ -32,25 +49,92 @@ private:
     Chip8* chip8 = nullptr;
 
     size_t tick = 0;
+    uint64_t next_frame_ns = 0; // When the next VIP frame is due
+    bool turbo = false;       // Run uncapped with muted audio
+    int present_every = 0;    // In turbo, present every Nth emulated frame; 0 = at the refresh rate
+    size_t presented_frame = 0;
+    size_t rendered_frame = 0; // Emulated frame of the last render, which the phosphor fades from
+    bool show_metrics = false;
+    SpeedMeter meter;
     int width = 0;
     int height = 0;
     int run_n_steps = 0;
     uint16_t keydown = 0x0000;
     
+    std::unique_ptr<Beeper> beeper;
+    std::array<int16_t, 1024> audio_scratch{};
+
+    // Runs on the SDL audio thread: must not allocate or touch the emulator
     static void audio_callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount) {
-        const int sample_rate = 48000;
-        const int freq = 440;
-        static int phase = 0;
-        
-        int samples_needed = additional_amount / sizeof(int16_t);
-        std::vector<int16_t> buffer(samples_needed);
-        
-        for (int i = 0; i < samples_needed; i++) {
-            buffer[i] = (phase < sample_rate / freq / 2) ? 3000 : -3000;
-            phase = (phase + 1) % (sample_rate / freq);
+        TRACE_THREAD("audio");
+        TRACE_SPAN("audio callback");
+        UI* ui = static_cast<UI*>(userdata);
+        size_t samples_needed = additional_amount / sizeof(int16_t);
+        while (samples_needed > 0) {
+            size_t n = std::min(samples_needed, ui->audio_scratch.size());
+            ui->beeper->drain(ui->audio_scratch.data(), n);
+            SDL_PutAudioStreamData(stream, ui->audio_scratch.data(), static_cast<int>(n * sizeof(int16_t)));
+            samples_needed -= n;
+        }
+    }
+
+    // Blocks on stdin until the console is left. Returns false if it asked to quit.
+    bool open_console(const Stop* stop = nullptr) {
+        DebugConsole console(debugger);
+        console.set_source_map(source_map);
+        if (stop) console.report(*stop, *chip8);
+        else std::cerr << "Debug console, type help for commands and continue to resume\n";
+        if (!console.run(std::cin, *chip8, keydown)) return false;
+        run_n_steps = -1;
+        return true;
+    }
+
+    // Blend and record the frame the machine is on, once per frame
+    void record_frame() {
+        blender.capture(*chip8);
+        if (capture && chip8->frame_count() != captured_frame) {
+            captured_frame = chip8->frame_count();
+            capture->push(chip8->display_rows());
         }
-        
-        SDL_PutAudioStreamData(stream, buffer.data(), samples_needed * sizeof(int16_t));
+    }
+
+    // Up to the next frame boundary, or the first breakpoint or watchpoint on the way
+    Stop run_to_frame_end() {
+        Stop stop;
+        for (size_t frame = chip8->frame_count(); chip8->frame_count() == frame && !chip8->finished();) {
+            size_t n = chip8->get_timing() == Timing::Vip ? 1 : TICKS_PER_FRAME - chip8->ticks() % TICKS_PER_FRAME;
+            stop = debugger.run(*chip8, n, keydown);
+            if (stop.reason == StopReason::Breakpoint || stop.reason == StopReason::Watchpoint) break;
+        }
+        return stop;
+    }
+
+    // One instruction per loop, or under VIP timing the whole of the next frame once it is
+    // due, so the machine keeps to 60 Hz frames. Single steps stay single instructions.
+    Stop advance() {
+        if (chip8->get_timing() != Timing::Vip || run_n_steps > 0) return debugger.run(*chip8, 1, keydown);
+        const uint64_t interval = 1000000000ull / VIP_FRAMES_PER_SECOND;
+        uint64_t now = SDL_GetTicksNS();
+        if (now < next_frame_ns) return Stop{};
+        next_frame_ns = (now - next_frame_ns > interval ? now : next_frame_ns) + interval;
+        return run_to_frame_end();
+    }
+
+    // Whole frames back to back for TURBO_SLICE_NS, or until a frame is due on screen
+    Stop run_turbo() {
+        const uint64_t until = SDL_GetTicksNS() + TURBO_SLICE_NS;
+        Stop stop;
+        do {
+            stop = run_to_frame_end();
+            if (stop.reason == StopReason::Breakpoint || stop.reason == StopReason::Watchpoint) break;
+            record_frame();
+        } while (SDL_GetTicksNS() < until && !chip8->finished() && !frame_due());
+        return stop;
+    }
+
+    // Turbo with present_every set presents on emulated frames rather than on the clock
+    bool frame_due() const {
+        return turbo && present_every > 0 && chip8->frame_count() >= presented_frame + present_every;
     }
 
 public:
@@ -59,42 +143,49 @@ public:
     UI(UI&&) = default;
     UI& operator=(UI&&) = default;
 
-    UI(PrivateTag, const char* title, int w, int h, Chip8& chip8) : chip8(&chip8), width(w), height(h) {
+    UI(PrivateTag, const char* title, int scale, Filter filter, Blend blend, Chip8& chip8)
+        : scaler(scale, filter), chip8(&chip8), width(scaler.width()), height(scaler.height()) {
+        blender.mode = blend;
         if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) throw std::runtime_error("Failed to initialize SDL");
-        sdl_window = SDL_CreateWindow(title, w, h, 0);
+        sdl_window = SDL_CreateWindow(title, width, height, 0);
         sdl_renderer = SDL_CreateRenderer(sdl_window, NULL);
-        sdl_texture = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+        sdl_texture = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, width, height);
         
         if (!sdl_window || !sdl_renderer || !sdl_texture) {
             throw std::runtime_error("Failed to create SDL window, renderer, or texture");
         }
         
         // Try to initialize audio (optional)
-        if (SDL_InitSubSystem(SDL_INIT_AUDIO) == 0) {
+        if (SDL_InitSubSystem(SDL_INIT_AUDIO)) {
             SDL_AudioSpec spec;
-            spec.freq = 48000;
+            spec.freq = AUDIO_SAMPLE_RATE;
             spec.format = SDL_AUDIO_S16;
             spec.channels = 1;
+            beeper = std::make_unique<Beeper>();
             sdl_audio_stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, audio_callback, this);
-            if (!sdl_audio_stream) {
+            if (sdl_audio_stream) {
+                SDL_ResumeAudioStreamDevice(sdl_audio_stream);
+            } else {
                 std::cerr << "Warning: Failed to initialize audio\n";
+                beeper.reset();
             }
         }
-        
-        frame_buffer.assign(static_cast<size_t>(width) * height, 0xFF000000u);
     }
 
     ~UI() {
         if (sdl_audio_stream) SDL_DestroyAudioStream(sdl_audio_stream);
+        if (beeper && beeper->underruns() > 0) {
+            std::cerr << "Audio underruns: " << beeper->underruns() << "\n";
+        }
         if (sdl_texture) SDL_DestroyTexture(sdl_texture);
         if (sdl_renderer) SDL_DestroyRenderer(sdl_renderer);
         if (sdl_window) SDL_DestroyWindow(sdl_window);
         SDL_Quit();
     }
 
-    static UI& create(const char* title, int w, int h, Chip8& chip8) {
+    static UI& create(const char* title, int scale, Filter filter, Blend blend, Chip8& chip8) {
         if (instance) throw std::runtime_error("UI instance already exists. Call destroy() first.");
-        instance.emplace(PrivateTag{}, title, w, h, chip8);
+        instance.emplace(PrivateTag{}, title, scale, filter, blend, chip8);
         return *instance;
     }
 
@@ -111,23 +202,58 @@ public:
         return instance.has_value();
     }
 
-    void display() {
-        if (!sdl_texture || frame_buffer.empty()) return;
+    // Record every completed frame to `c` (not owned), nullptr to stop
+    void set_capture(Capture* c) {
+        capture = c;
+        captured_frame = chip8->frame_count();
+    }
 
-        char* pix;
-        int pitch;
-        SDL_LockTexture(sdl_texture, NULL, (void**)&pix, &pitch);
-        for (int i = 0, sp = 0, dp = 0; i < height; i++, dp += width, sp += pitch)
-            memcpy(pix + sp, frame_buffer.data() + dp, width * 4);
+    // Start in turbo; `every` > 0 presents only every Nth emulated frame
+    void set_turbo(bool on, int every = 0) {
+        turbo = on;
+        present_every = every;
+    }
+
+    // Assembler source map; single steps then report the source line being executed
+    void set_source_map(const SourceMap* map) { source_map = map; }
 
-        SDL_UnlockTexture(sdl_texture);  
+    void display() {
+        if (!sdl_texture) return;
+
+        {
+            TRACE_SPAN("texture upload");
+            uint32_t* pix;
+            int pitch;
+            if (!SDL_LockTexture(sdl_texture, NULL, (void**)&pix, &pitch)) return;
+            // Blending only makes sense while frames are completing; show the live display when paused
+            const uint64_t* ghost = nullptr;
+            const uint64_t* rows = run_n_steps < 0 ? blender.compose(*chip8, ghost) : chip8->display_rows();
+            const size_t frame = chip8->frame_count();
+            scaler.render(rows, pix, pitch, ghost, frame >= rendered_frame ? frame - rendered_frame : 1);
+            rendered_frame = frame;
+            SDL_UnlockTexture(sdl_texture);
+        }
+        TRACE_SPAN("present");
         SDL_RenderTexture(sdl_renderer, sdl_texture, NULL, NULL);
+        if (show_metrics || turbo) {
+            SDL_SetRenderDrawColor(sdl_renderer, 255, 255, 0, 255);
+            SDL_RenderDebugText(sdl_renderer, 4, 4, meter.describe(chip8->frames_per_second(), turbo).c_str());
+        }
+        if (chip8->fault() != Fault::None) {
+            SDL_SetRenderDrawColor(sdl_renderer, 255, 64, 64, 255);
+            SDL_RenderDebugText(sdl_renderer, 4, 16, ("FAULT " + chip8->fault_message()).c_str());
+        }
         SDL_RenderPresent(sdl_renderer);
     }
 
     bool loop() {
         SDL_Event e;
-        if (SDL_PollEvent(&e)) {
+        bool polled;
+        {
+            TRACE_SPAN("poll events");
+            polled = SDL_PollEvent(&e);
+        }
+        if (polled) {
             if (e.type == SDL_EVENT_QUIT) {
                 chip8->quit();
                 return false;
@@ -138,9 +264,38 @@ public:
                         chip8->quit();
                         return false;
                     case SDLK_SPACE:
-                        std::cerr << "Stepping one instruction\n";
+                        std::cerr << "Stepping one instruction at " << hex(chip8->program_counter(), 4);
+                        if (source_map) {
+                            std::string line = source_map->describe(chip8->program_counter());
+                            if (!line.empty()) std::cerr << " (" << line << ")";
+                        }
+                        std::cerr << "\n";
                         run_n_steps = 1;
                         break;
+                    case SDLK_TAB: {
+                        Filter next = static_cast<Filter>((static_cast<int>(scaler.get_filter()) + 1) % 4);
+                        std::cerr << "Filter: " << filter_name(next) << "\n";
+                        scaler.set_filter(next);
+                        break;
+                    }
+                    case SDLK_F1:
+                        show_metrics = !show_metrics;
+                        break;
+                    case SDLK_F2:
+                        turbo = !turbo;
+                        std::cerr << "Turbo: " << (turbo ? "on" : "off") << "\n";
+                        break;
+                    case SDLK_GRAVE:
+                        run_n_steps = 0;
+                        if (!open_console()) {
+                            chip8->quit();
+                            return false;
+                        }
+                        break;
+                    case SDLK_B:
+                        blender.mode = static_cast<Blend>((static_cast<int>(blender.mode) + 1) % 3);
+                        std::cerr << "Blend: " << blend_name(blender.mode) << "\n";
+                        break;
                     case SDLK_RETURN:
                         if (run_n_steps == 0) {
                             std::cerr << "Toggle running\n";
@@ -162,26 +317,41 @@ public:
             }
         }
         if (run_n_steps != 0) {
+            TRACE_SPAN("emulate");
             tick++;
-            chip8->step(frame_buffer, width, height, keydown);
+            Stop stop = turbo && run_n_steps < 0 ? run_turbo() : advance();
+            if (stop.reason == StopReason::Breakpoint || stop.reason == StopReason::Watchpoint) {
+                run_n_steps = 0;
+                if (!open_console(&stop)) {
+                    chip8->quit();
+                    return false;
+                }
+            }
+            record_frame();
             run_n_steps -= run_n_steps > 0;
         }
         
-        // Control sound (only if audio is available)
-        if (sdl_audio_stream) {
-            if (chip8->is_beeping() && !SDL_GetAudioStreamAvailable(sdl_audio_stream)) {
-                SDL_ResumeAudioStreamDevice(sdl_audio_stream);
-            } else if (!chip8->is_beeping()) {
-                SDL_PauseAudioStreamDevice(sdl_audio_stream);
-            }
+        // Queue audio for the time that has passed (only if audio is available)
+        if (beeper) {
+            TRACE_SPAN("audio feed");
+            beeper->feed(*chip8, SDL_GetTicksNS(), turbo);
         }
         
-        SDL_Delay(1); // Prevent CPU hogging 1000Hz
+        if (!turbo) SDL_Delay(1); // Prevent CPU hogging 1000Hz
         return true;
     }
 
     void run() {
+        const uint64_t present_interval_ns = 1000000000ull / 60;
+        uint64_t last_present = 0;
         while (loop()) {
+            uint64_t now = SDL_GetTicksNS();
+            meter.update(now, chip8->frame_count(), chip8->ticks());
+            // Turbo with present_every follows emulated frames; otherwise present at the refresh rate
+            bool by_frame = turbo && present_every > 0 && run_n_steps < 0 && !chip8->finished();
+            if (by_frame ? !frame_due() : now - last_present < present_interval_ns) continue;
+            last_present = now;
+            presented_frame = chip8->frame_count();
             display();
         }
     }
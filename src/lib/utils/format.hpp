@@ -4,9 +4,12 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <stdexcept>
+#include <ostream>
+#include <string_view>
 
 // Custom format helper for hex values
-inline std::string hex(unsigned int value, int width = 0) {
+inline std::string hex(unsigned long long value, int width = 0) {
     std::ostringstream oss;
     oss << "0x" << std::hex << std::setfill('0');
     if (width > 0) oss << std::setw(width);
@@ -20,6 +23,16 @@ inline std::string reg(unsigned int value) {
     return oss.str();
 }
 
+// A whole number for a command line option, in `base` (0 also accepts 0x and 0 prefixes).
+// std::stoul alone accepts "12abc" and wraps "-1"; throws std::invalid_argument or
+// std::out_of_range instead.
+inline size_t parse_count(const std::string& text, int base = 10) {
+    size_t used = 0;
+    unsigned long long value = text.empty() || text[0] == '-' ? 0 : std::stoull(text, &used, base);
+    if (used == 0 || used != text.size()) throw std::invalid_argument(text);
+    return static_cast<size_t>(value);
+}
+
 // String formatting helper - similar to fprintf but returns std::string
 template<typename... Args>
 inline std::string fmt(const std::string& format, Args... args) {
@@ -42,4 +55,67 @@ inline std::string fmt(const std::string& format, Args... args) {
     return result.str();
 }
 
+#define LISTING_FLUSH_SIZE (64 * 1024) // Bytes buffered before a listing is written out
+
+// Append-only text buffer for hot output paths such as disassembly listings. Produces the
+// same text as hex()/reg() without a stream per call; reuse one instance so its storage
+// stops growing, and flush it in large writes.
+class TextBuffer {
+private:
+    std::string data;
+
+public:
+    TextBuffer& put(std::string_view s) {
+        data.append(s.data(), s.size());
+        return *this;
+    }
+
+    TextBuffer& put(char c) {
+        data.push_back(c);
+        return *this;
+    }
+
+    // Lower case hex, zero padded to `width` digits, like hex()
+    TextBuffer& put_hex(unsigned long long value, int width = 0, bool prefix = true) {
+        static const char digits[] = "0123456789abcdef";
+        char buf[16];
+        int n = 0;
+        do {
+            buf[n++] = digits[value & 0xF];
+            value >>= 4;
+        } while (value);
+        if (prefix) data.append("0x", 2);
+        for (int i = n; i < width; i++) data.push_back('0');
+        while (n) data.push_back(buf[--n]);
+        return *this;
+    }
+
+    TextBuffer& put_dec(unsigned long long value) {
+        char buf[20];
+        int n = 0;
+        do {
+            buf[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (n) data.push_back(buf[--n]);
+        return *this;
+    }
+
+    TextBuffer& put_reg(unsigned int value) {
+        data.push_back('V');
+        data.push_back("0123456789abcdef"[value & 0xF]);
+        return *this;
+    }
+
+    std::string_view view() const { return data; }
+    size_t size() const { return data.size(); }
+    void clear() { data.clear(); }
+    void truncate(size_t n) { data.resize(n); }
+
+    void flush(std::ostream& out) {
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        data.clear();
+    }
+};
+
 #endif
\ No newline at end of file
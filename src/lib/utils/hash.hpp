@@ -0,0 +1,33 @@
+#ifndef SRC_LIB_HASH_HPP
+#define SRC_LIB_HASH_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// splitmix64 finaliser, a cheap full-avalanche 64-bit mix
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Content hash for ROM images and machine state, eight bytes per round
+inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t hash = mix64(seed ^ (size * 0x9e3779b97f4a7c15ull));
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, p + i, 8);
+        hash = mix64(hash ^ word) + 0x9e3779b97f4a7c15ull;
+    }
+    uint64_t tail = 0;
+    for (size_t j = 0; i + j < size; j++) tail |= static_cast<uint64_t>(p[i + j]) << (j * 8);
+    return mix64(hash ^ tail);
+}
+
+#endif
@@ -0,0 +1,107 @@
+#include "trace.hpp"
+
+#ifdef CHIP8_TRACE
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+// Written only by its thread; the writer reads up to `count`
+struct ThreadTrace {
+    int tid = 0;
+    std::atomic<const char*> name{nullptr};
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[TRACE_EVENTS_PER_THREAD]};
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> dropped{0};
+};
+
+// Buffers outlive their threads so spans from finished threads are still written
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadTrace>> threads;
+    std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+ThreadTrace& this_thread() {
+    thread_local ThreadTrace* mine = nullptr;
+    if (!mine) {
+        TraceRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(std::make_unique<ThreadTrace>());
+        mine = r.threads.back().get();
+        mine->tid = static_cast<int>(r.threads.size());
+    }
+    return *mine;
+}
+
+}
+
+uint64_t trace_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().origin).count();
+}
+
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    ThreadTrace& t = this_thread();
+    size_t n = t.count.load(std::memory_order_relaxed);
+    if (n == TRACE_EVENTS_PER_THREAD) {
+        t.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    t.events[n] = {name, start_ns, end_ns - start_ns};
+    t.count.store(n + 1, std::memory_order_release);
+}
+
+void trace_thread_name(const char* name) {
+    this_thread().name.store(name, std::memory_order_relaxed);
+}
+
+bool trace_write(const std::string& path) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) return false;
+    TraceRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+    bool first = true;
+    for (const auto& t : r.threads) {
+        const char* name = t->name.load(std::memory_order_relaxed);
+        if (name) {
+            fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", t->tid, name);
+            first = false;
+        }
+        size_t n = t->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; i++) {
+            const TraceEvent& e = t->events[i];
+            fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", e.name, t->tid, e.start_ns / 1000.0, e.duration_ns / 1000.0);
+            first = false;
+        }
+        size_t dropped = t->dropped.load(std::memory_order_relaxed);
+        if (dropped) fprintf(stderr, "Trace: dropped %zu spans on thread %d\n", dropped, t->tid);
+    }
+    fputs("\n]}\n", out);
+    return fclose(out) == 0;
+}
+
+#else
+
+bool trace_write(const std::string&) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SRC_LIB_TRACE_HPP
+#define SRC_LIB_TRACE_HPP
+
+#include <cstdint>
+#include <string>
+
+// Host-side profiling spans, written as Chrome trace JSON for chrome://tracing or Perfetto.
+// Only built with -DCHIP8_TRACE=ON; otherwise TRACE_SPAN and TRACE_THREAD expand to nothing.
+//   TRACE_SPAN("present");  // Times the rest of the enclosing scope
+//   TRACE_THREAD("audio");  // Names the calling thread in the trace
+// Names must be string literals. Each thread buffers its own spans, so recording never
+// takes a lock after a thread's first span.
+#ifdef CHIP8_TRACE
+#define TRACE_ENABLED 1
+#define TRACE_EVENTS_PER_THREAD (1 << 17) // Further spans on a thread are counted and dropped
+
+uint64_t trace_now_ns();
+void trace_record(const char* name, uint64_t start_ns, uint64_t end_ns);
+void trace_thread_name(const char* name);
+
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t start;
+
+public:
+    explicit TraceSpan(const char* name): name(name), start(trace_now_ns()) {}
+    ~TraceSpan() { trace_record(name, start, trace_now_ns()); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
+#define TRACE_THREAD(name) trace_thread_name(name)
+#else
+#define TRACE_ENABLED 0
+#define TRACE_SPAN(name) ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#endif
+
+// Write every thread's spans so far to `path`. False if tracing is not built in or the
+// file cannot be written.
+bool trace_write(const std::string& path);
+
+#endif
@@ -0,0 +1,20 @@
+# Hashes the library sources into lib_version.hpp for the result cache. Runs on every
+# build, but the header is only rewritten when the hash changes, so nothing recompiles
+# unless a library source did.
+#   cmake -DSOURCES="a.cpp;b.hpp" -DOUTPUT=lib_version.hpp -P version.cmake
+set(hashes "")
+foreach(source ${SOURCES})
+    file(SHA256 ${source} hash)
+    string(APPEND hashes ${hash})
+endforeach()
+string(SHA256 version "${hashes}")
+string(SUBSTRING ${version} 0 16 version)
+
+set(header "#define CHIP8_LIB_VERSION \"${version}\"\n")
+set(previous "")
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} previous)
+endif()
+if (NOT previous STREQUAL header)
+    file(WRITE ${OUTPUT} ${header})
+endif()
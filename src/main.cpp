@@ -1,24 +1,128 @@
+#include <climits>
 #include <iostream>
 #include <memory>
 #include <cstring>
+#include <stdexcept>
 #include <fstream>
+#include <string>
+#include "lib/analysis/analysis.hpp"
 #include "lib/chip8/chip8.hpp"
 #include "lib/ui/ui.hpp"
+#include "lib/capture/capture.hpp"
+#include "lib/asm/source_map.hpp"
+#include "lib/utils/format.hpp"
+#include "lib/utils/trace.hpp"
+
+static int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " <rom_file> [--scale N] [--filter nearest|scanline|grid|phosphor] [--blend off|or|decay] [--timing fixed|vip] [--engine auto|reference|switch|predecoded] [--turbo N] [--capture out.y4m|out.gif] [--map rom.map] [--trace out.json]\n";
+    return 1;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc < 2 || !argv[1]) {
-        std::cerr << "Usage: " << argv[0] << " <rom_file>\n";
-        return 1;
-    }
+    if (argc < 2 || !argv[1]) return usage(argv[0]);
     const char* rom_path = argv[1];
+    int scale = 10;
+    Filter filter = Filter::Nearest;
+    Blend blend = Blend::Off;
+    std::string capture_path;
+    std::string map_path;
+    std::string trace_path;
+    Timing timing = Timing::Fixed;
+    Engine engine = Engine::Reference;
+    bool auto_engine = true; // fastest_safe_engine for the ROM
+    int turbo_every = -1;
+    for (int i = 2; i < argc; i += 2) {
+        std::string opt = argv[i];
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << opt << "\n";
+            return usage(argv[0]);
+        }
+        std::string value = argv[i + 1];
+        try {
+            if (opt == "--scale") {
+                size_t n = parse_count(value);
+                if (n < 1 || n > INT_MAX) throw std::out_of_range(value);
+                scale = static_cast<int>(n);
+            } else if (opt == "--filter") {
+                if (!parse_filter(value, filter)) {
+                    std::cerr << "Unknown filter: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--blend") {
+                if (!parse_blend(value, blend)) {
+                    std::cerr << "Unknown blend mode: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--timing") {
+                if (!parse_timing(value, timing)) {
+                    std::cerr << "Unknown timing: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--engine") {
+                auto_engine = value == "auto";
+                if (!auto_engine && !parse_engine(value, engine)) {
+                    std::cerr << "Unknown engine: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--turbo") {
+                size_t n = parse_count(value);
+                if (n > INT_MAX) throw std::out_of_range(value);
+                turbo_every = static_cast<int>(n);
+            } else if (opt == "--capture") {
+                capture_path = value;
+            } else if (opt == "--map") {
+                map_path = value;
+            } else if (opt == "--trace") {
+                if (!TRACE_ENABLED) {
+                    std::cerr << "Tracing is not built in, configure with -DCHIP8_TRACE=ON\n";
+                    return 1;
+                }
+                trace_path = value;
+            } else {
+                std::cerr << "Unknown option: " << opt << "\n";
+                return usage(argv[0]);
+            }
+        } catch (const std::logic_error&) {
+            std::cerr << "Bad value for " << opt << ": " << value << "\n";
+            return usage(argv[0]);
+        }
+    }
 
     Chip8 chip8;
+    chip8.set_timing(timing);
     if (!chip8.loadRom(rom_path)) {
-        throw std::runtime_error("Failed to load ROM");
+        std::cerr << "Failed to load ROM: " << rom_path << "\n";
         return 1;
     }
+    chip8.set_engine(auto_engine ? fastest_safe_engine(chip8) : engine);
 
-    UI& ui = UI::create("Chip8", 64, 32, chip8);
+    std::unique_ptr<Capture> capture;
+    if (!capture_path.empty()) {
+        CaptureFormat format;
+        if (!capture_format_for(capture_path, format)) {
+            std::cerr << "Unknown capture format: " << capture_path << "\n";
+            return 1;
+        }
+        capture = std::make_unique<Capture>(capture_path, format, scale, chip8.frames_per_second());
+    }
+
+    SourceMap source_map;
+    if (!map_path.empty()) source_map = SourceMap::load(map_path);
+
+    TRACE_THREAD("main");
+    UI& ui = UI::create("Chip8", scale, filter, blend, chip8);
+    ui.set_capture(capture.get());
+    if (turbo_every >= 0) ui.set_turbo(true, turbo_every);
+    if (!map_path.empty()) ui.set_source_map(&source_map);
     ui.run();
+    ui.set_capture(nullptr);
+    UI::destroy(); // Stops the audio thread before its spans are written
+    if (chip8.fault() != Fault::None) std::cerr << "Fault: " << chip8.fault_message() << "\n";
+    if (!trace_path.empty() && !trace_write(trace_path)) {
+        std::cerr << "Failed to write trace " << trace_path << "\n";
+    }
+    if (capture && capture->dropped() > 0) {
+        std::cerr << "Capture dropped " << capture->dropped() << " frames\n";
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,91 @@
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "lib/rom/rom.hpp"
+#include "lib/utils/format.hpp"
+
+// Builds and queries a content-hash index of a ROM corpus
+
+static bool is_rom_file(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    return ext == ".ch8" || ext == ".c8" || ext == ".sc8" || ext == ".xo8";
+}
+
+static void print_entry(const RomIndex& index, const RomIndexEntry& entry) {
+    std::cout << hex(entry.hash, 16) << " " << entry.size << " "
+              << platform_name(static_cast<Platform>(entry.platform)) << " "
+              << quirk_names(entry.quirks) << " " << index.name(entry) << "\n";
+}
+
+static int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " build <index> <dir|rom>...\n"
+              << "       " << argv0 << " list <index>\n"
+              << "       " << argv0 << " lookup <index> <rom|0xhash>\n";
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) return usage(argv[0]);
+    std::string command = argv[1];
+    std::string index_path = argv[2];
+
+    try {
+        if (command == "build" && argc >= 4) {
+            std::vector<std::string> paths;
+            for (int i = 3; i < argc; i++) {
+                std::filesystem::path root(argv[i]);
+                if (!std::filesystem::is_directory(root)) {
+                    paths.push_back(root.string());
+                    continue;
+                }
+                for (const auto& file : std::filesystem::recursive_directory_iterator(root)) {
+                    if (file.is_regular_file() && is_rom_file(file.path())) paths.push_back(file.path().string());
+                }
+            }
+            // Reuse hashes from the existing index for files that have not changed
+            std::unique_ptr<RomIndex> previous;
+            if (std::filesystem::exists(index_path)) {
+                try {
+                    previous = std::make_unique<RomIndex>(index_path);
+                } catch (const std::runtime_error&) {
+                    std::cerr << "Ignoring invalid index " << index_path << "\n";
+                }
+            }
+            RomIndexStats stats = build_rom_index(paths, index_path, previous.get());
+            std::cout << stats.hashed + stats.reused << " ROMs indexed (" << stats.hashed << " hashed, "
+                      << stats.reused << " unchanged, " << stats.skipped << " skipped)\n";
+            return 0;
+        }
+
+        RomIndex index(index_path);
+        if (command == "list") {
+            for (size_t i = 0; i < index.size(); i++) print_entry(index, index.at(i));
+            return 0;
+        }
+        if (command == "lookup" && argc == 4) {
+            std::string key = argv[3];
+            uint64_t hash;
+            if (key.rfind("0x", 0) == 0) {
+                hash = std::stoull(key, nullptr, 16);
+            } else {
+                MappedRom rom(key);
+                hash = analyze_rom(rom.data(), rom.size()).hash;
+            }
+            const RomIndexEntry* entry = index.find(hash);
+            if (!entry) {
+                std::cout << "not found: " << hex(hash, 16) << "\n";
+                return 1;
+            }
+            // Duplicates are adjacent because entries are sorted by hash
+            for (; entry < &index.at(0) + index.size() && entry->hash == hash; entry++) print_entry(index, *entry);
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return usage(argv[0]);
+}
@@ -0,0 +1,103 @@
+#include <iostream>
+#include <string>
+#include "lib/analysis/analysis.hpp"
+#include "lib/chip8/chip8.hpp"
+#include "lib/search/search.hpp"
+#include "lib/utils/format.hpp"
+
+static int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " <rom_file> --goal \"V3 == 5\" [--goal ...] [--strategy bfs|beam|mcts] [--depth N] [--frames N] [--threads N] [--beam N] [--iterations N] [--states N] [--score ADDR] [--timing fixed|vip] [--engine auto|reference|switch|predecoded]\n";
+    return 1;
+}
+
+// Finds keypad inputs that take a ROM from boot to a goal state
+int main(int argc, char* argv[]) {
+    if (argc < 2 || !argv[1]) return usage(argv[0]);
+    const char* rom_path = argv[1];
+    SearchGoal goal;
+    SearchOptions options;
+    Timing timing = Timing::Fixed;
+    Engine engine = Engine::Reference;
+    bool auto_engine = true; // fastest_safe_engine for the ROM
+    for (int i = 2; i < argc; i += 2) {
+        std::string opt = argv[i];
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << opt << "\n";
+            return usage(argv[0]);
+        }
+        std::string value = argv[i + 1];
+        try {
+            if (opt == "--goal") {
+                if (!parse_goal_term(value, goal)) {
+                    std::cerr << "Bad goal: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--strategy") {
+                if (!parse_strategy(value, options.strategy)) {
+                    std::cerr << "Unknown strategy: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--timing") {
+                if (!parse_timing(value, timing)) {
+                    std::cerr << "Unknown timing: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--engine") {
+                auto_engine = value == "auto";
+                if (!auto_engine && !parse_engine(value, engine)) {
+                    std::cerr << "Unknown engine: " << value << "\n";
+                    return 1;
+                }
+            } else if (opt == "--depth") {
+                options.max_depth = parse_count(value);
+            } else if (opt == "--frames") {
+                options.frames_per_action = parse_count(value);
+            } else if (opt == "--threads") {
+                options.threads = parse_count(value);
+            } else if (opt == "--beam") {
+                options.beam_width = parse_count(value);
+            } else if (opt == "--iterations") {
+                options.iterations = parse_count(value);
+            } else if (opt == "--states") {
+                options.max_states = parse_count(value);
+            } else if (opt == "--score") {
+                options.score_addr = static_cast<int>(parse_count(value, 0) & MEM_MASK);
+            } else {
+                std::cerr << "Unknown option: " << opt << "\n";
+                return usage(argv[0]);
+            }
+        } catch (const std::logic_error&) {
+            std::cerr << "Bad value for " << opt << ": " << value << "\n";
+            return usage(argv[0]);
+        }
+    }
+    if (goal.terms() == 0) {
+        std::cerr << "No --goal given\n";
+        return 1;
+    }
+
+    Chip8 chip8;
+    chip8.set_timing(timing);
+    if (!chip8.loadRom(rom_path)) {
+        std::cerr << "Failed to load ROM: " << rom_path << "\n";
+        return 1;
+    }
+    if (auto_engine) {
+        // Not fastest_safe_engine: every search node is a copy of the machine,
+        // and copying the predecoded table costs more than decoding as it runs
+        engine = Engine::Switch;
+    }
+    chip8.set_engine(engine);
+
+    SearchResult result = search(chip8, goal, options);
+    std::cout << "strategy: " << strategy_name(options.strategy) << "\n";
+    std::cout << "found: " << (result.found ? "yes" : "no") << "\n";
+    std::cout << (result.found ? "keys: " : "best: ") << plan_script(result.inputs, options.frames_per_action) << "\n";
+    std::cout << "inputs: " << result.inputs.size() << "\n";
+    std::cout << "depth: " << result.depth << "\n";
+    std::cout << "expanded: " << result.expanded << "\n";
+    std::cout << "unique: " << result.unique << "\n";
+    std::cout << "threads: " << result.threads << "\n";
+    std::cout << "states/s: " << static_cast<size_t>(result.states_per_second()) << "\n";
+    return result.found ? 0 : 2;
+}
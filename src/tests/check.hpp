@@ -0,0 +1,29 @@
+#ifndef SRC_TESTS_CHECK_HPP
+#define SRC_TESTS_CHECK_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "asm/assembler.hpp"
+#include "chip8/chip8.hpp"
+
+// Shared by the test executables: each check prints a PASS or FAIL line, and main
+// returns non-zero when any failed
+inline int failures = 0;
+
+inline void check(bool ok, const std::string& what) {
+    std::cout << (ok ? "PASS " : "FAIL ") << what << "\n";
+    failures += !ok;
+}
+
+// Assemble `source` and load it as the ROM
+inline void load(Chip8& chip8, const std::string& source) {
+    Assembler assembler;
+    assembler.assemble_source(source, "test.s");
+    assembler.finish();
+    std::vector<uint8_t> image = assembler.image();
+    if (!chip8.loadRom(image.data(), image.size())) check(false, "load assembled program");
+}
+
+#endif
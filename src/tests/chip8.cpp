@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "check.hpp"
+
+// Faults, halt reasons, budgets, the sound edge log and reset on small assembled programs
+
+// V0 counts up forever
+static const char* const counter =
+    "    LDI 0x300\n"
+    "    LDV V0, 0\n"
+    "    LDV V1, 0\n"
+    "loop:\n"
+    "    ADDV V0, 1\n"
+    "    BCD V0\n"
+    "    DRW V1, V1, 2\n"
+    "    JP loop\n";
+
+// Steps until the machine halts or `n` instructions have run, and returns how many ran
+static size_t run(Chip8& chip8, size_t n) {
+    size_t steps = 0;
+    for (; steps < n && !chip8.finished(); steps++) chip8.step(0);
+    return steps;
+}
+
+int main() {
+    for (Engine engine : {Engine::Reference, Engine::Switch}) {
+        std::string label = std::string(" (") + engine_name(engine) + ")";
+        Chip8 chip8;
+        chip8.set_engine(engine);
+        load(chip8, "    LDV V0, 1\n    RET\n");
+        size_t steps = run(chip8, 100);
+        check(steps == 2 && chip8.halt() == Halt::Fault && chip8.fault() == Fault::StackUnderflow &&
+              chip8.fault_pc() == 0x202 && chip8.fault_opcode() == 0x00EE && chip8.program_counter() == 0x202 &&
+              chip8.finished(), "RET on an empty stack faults" + label);
+        chip8.step(0);
+        check(chip8.program_counter() == 0x202 && chip8.stack_pointer() == 0, "a faulted machine stays halted" + label);
+
+        load(chip8, "loop:\n    CALL loop\n");
+        check(chip8.fault() == Fault::None && !chip8.finished(), "loading a ROM clears the fault" + label);
+        steps = run(chip8, 100);
+        check(steps == 17 && chip8.halt() == Halt::Fault && chip8.fault() == Fault::StackOverflow &&
+              chip8.stack_pointer() == 16 && chip8.fault_message() == "stack overflow at 0x200 (0x2200)",
+              "the seventeenth CALL faults" + label);
+
+        // Unknown opcodes run as no-ops and only the first few are reported
+        std::ostringstream errors;
+        std::streambuf* cerr_buf = std::cerr.rdbuf(errors.rdbuf());
+        chip8.reset();
+        load(chip8, "loop:\n    DW 0xF0FF\n    JP loop\n");
+        steps = run(chip8, 200);
+        std::cerr.rdbuf(cerr_buf);
+        std::string reported = errors.str();
+        size_t lines = std::count(reported.begin(), reported.end(), '\n');
+        check(steps == 200 && !chip8.finished() && chip8.unknown_opcodes() == 100 && lines == UNKNOWN_OPCODE_REPORTS + 1,
+              "unknown opcodes are counted and reported a few times" + label);
+    }
+    for (Engine engine : {Engine::Reference, Engine::Switch}) {
+        std::string label = std::string(" (") + engine_name(engine) + ")";
+        Chip8 chip8;
+        chip8.set_engine(engine);
+        // Code copied past the end of the ROM and run from there: STR writes JP 0x300 to 0x300
+        load(chip8, "    LDV V0, 0x13\n    LDV V1, 0x00\n    LDI 0x300\n    STR I, V1\n    JP 0x300\n");
+        size_t steps = run(chip8, 100);
+        check(steps == 6 && chip8.halt() == Halt::SelfJump &&
+              chip8.program_counter() == 0x300, "running code outside the ROM, then a self jump halts" + label);
+
+        load(chip8, "    LDV V0, 60\n    ST.DT V0\nend:\n    JP end\n");
+        steps = run(chip8, 1000);
+        check(chip8.halt() == Halt::SelfJump && chip8.delay_timer() == 0 && steps > 60,
+              "a self jump waits for the delay timer" + label);
+
+        chip8.set_budget(50, 0);
+        chip8.reset();
+        load(chip8, counter);
+        steps = run(chip8, 1000);
+        check(steps == 50 && chip8.halt() == Halt::InstructionBudget,
+              "instruction budget" + label);
+        chip8.set_budget(0, 3);
+        chip8.reset();
+        load(chip8, counter);
+        for (int frame = 0; frame < 10; frame++) chip8.run_frame(0);
+        check(chip8.halt() == Halt::FrameBudget && chip8.frame_count() == 3, "frame budget" + label);
+        chip8.set_budget(0, 0);
+    }
+    for (Engine engine : {Engine::Reference, Engine::Switch}) {
+        for (Timing timing : {Timing::Fixed, Timing::Vip}) {
+            std::string label = std::string(" (") + engine_name(engine) + ", " + timing_name(timing) + ")";
+            Chip8 chip8;
+            chip8.set_engine(engine);
+            chip8.set_timing(timing);
+            // The beep starts at the second instruction and stops when the timer runs out
+            load(chip8, "    LDV V0, 3\n    ST.ST V0\nend:\n    JP end\n");
+            while (!chip8.finished()) chip8.step(0);
+            check(chip8.halt() == Halt::SelfJump && chip8.sound_edges() == 2 && chip8.sound_edge(0).on &&
+                  chip8.sound_edge(0).tick == 2 && !chip8.sound_edge(1).on &&
+                  chip8.sound_edge(1).tick > 2 && chip8.sound_edge(1).tick < chip8.ticks(),
+                  "sound timer edges are logged" + label);
+            chip8.reset();
+            check(chip8.sound_edges() == 0, "reset clears the sound edges" + label);
+        }
+    }
+    for (Engine engine : {Engine::Reference, Engine::Switch, Engine::Predecoded}) {
+        std::string label = std::string(" (") + engine_name(engine) + ")";
+        Chip8 chip8, fresh;
+        chip8.set_engine(engine);
+        fresh.set_engine(engine);
+        load(chip8, counter);
+        load(fresh, counter);
+        const std::vector<uint8_t> loaded(chip8.ram(), chip8.ram() + MEM_SIZE);
+        const uint64_t loaded_hash = chip8.state_hash();
+        for (int frame = 0; frame < 5; frame++) chip8.run_frame(0);
+        chip8.poke(0x200, 0x12); // JP 0x200: halts at once unless reset restores the code
+        chip8.poke(0x201, 0x00);
+        chip8.reset();
+        check(std::equal(loaded.begin(), loaded.end(), chip8.ram()) && chip8.ticks() == 0 &&
+              chip8.display_rows()[0] == 0 && chip8.state_hash() == loaded_hash &&
+              chip8.full_state_hash() == loaded_hash, "reset restores the loaded ROM" + label);
+        for (int frame = 0; frame < 5; frame++) {
+            chip8.run_frame(0);
+            fresh.run_frame(0);
+        }
+        check(!chip8.finished() && chip8.state_hash() == fresh.state_hash(), "a reset machine runs like a new one" + label);
+
+        const uint8_t too_big[MEM_SIZE - MEM_START + 1] = {};
+        check(!chip8.loadRom(too_big, sizeof(too_big)) && chip8.state_hash() == fresh.state_hash(),
+              "an oversized ROM leaves the machine alone" + label);
+        Chip8 blank;
+        blank.set_engine(engine);
+        load(chip8, "");
+        check(chip8.state_hash() == blank.state_hash() && chip8.rom_size() == 0, "an empty ROM is the power-on state" + label);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "debug/console.hpp"
+#include "debug/debugger.hpp"
+
+// Breakpoints, watchpoints and the console on small assembled programs
+
+// V0 counts up forever; 0x206 is the top of the loop
+static const char* const counter =
+    "    LDI 0x300\n"
+    "    LDV V0, 0\n"
+    "    LDV V1, 0\n"
+    "loop:\n"
+    "    ADDV V0, 1\n"
+    "    BCD V0\n"
+    "    DRW V1, V1, 2\n"
+    "    JP loop\n";
+
+int main() {
+    {
+        Chip8 plain, debugged;
+        load(plain, counter);
+        load(debugged, counter);
+        for (int i = 0; i < 100; i++) plain.step(0);
+        Debugger debugger;
+        Stop stop = debugger.run(debugged, 100, 0);
+        check(stop.reason == StopReason::Steps && stop.steps == 100 &&
+              plain.program_counter() == debugged.program_counter() && plain.registers()[0] == debugged.registers()[0],
+              "nothing set runs like plain steps");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, counter);
+        Debugger debugger;
+        int id = debugger.add_breakpoint(0x206);
+        Stop stop = debugger.run(chip8, 1000, 0);
+        check(stop.reason == StopReason::Breakpoint && stop.id == id && stop.steps == 3 &&
+              chip8.program_counter() == 0x206 && chip8.registers()[0] == 0, "breakpoint stops before the instruction");
+        stop = debugger.run(chip8, 1000, 0);
+        check(stop.reason == StopReason::Breakpoint && stop.steps == 4 && chip8.registers()[0] == 1,
+              "resuming runs the loop once and stops again");
+        debugger.remove(id);
+        stop = debugger.run(chip8, 1000, 0);
+        check(stop.reason == StopReason::Steps && stop.steps == 1000 && !debugger.armed(), "removed breakpoint");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, counter);
+        Debugger debugger;
+        Condition condition;
+        condition.active = true;
+        condition.reg = 0;
+        condition.op = Compare::Eq;
+        condition.value = 5;
+        debugger.add_breakpoint(0x206, condition);
+        Stop stop = debugger.run(chip8, 1000, 0);
+        check(stop.reason == StopReason::Breakpoint && chip8.registers()[0] == 5, "conditional breakpoint");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, counter);
+        Debugger debugger;
+        debugger.add_watchpoint(0x302, 0x302, ACCESS_WRITE);
+        Stop stop = debugger.run(chip8, 1000, 0);
+        check(stop.reason == StopReason::Watchpoint && stop.addr == 0x302 && stop.access == ACCESS_WRITE &&
+              chip8.program_counter() == 0x20a && chip8.ram()[0x302] == 1, "write watchpoint stops after BCD");
+
+        Debugger reads;
+        reads.add_watchpoint(0x301, 0x3ff, ACCESS_READ);
+        stop = reads.run(chip8, 1000, 0);
+        check(stop.reason == StopReason::Watchpoint && stop.addr == 0x301 && stop.access == ACCESS_READ &&
+              chip8.program_counter() == 0x20c, "read watchpoint stops after DRW");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, counter);
+        Debugger debugger;
+        DebugConsole console(debugger, std::cout);
+        std::istringstream commands(
+            "break 0x206 if v0 >= 3\n"
+            "watch 0x300+3 rw\n"
+            "break nowhere\n"
+            "info\n"
+            "continue\n");
+        bool resumed = console.run(commands, chip8, 0);
+        check(resumed && debugger.breakpoints().size() == 1 && debugger.watchpoints().size() == 1 &&
+              debugger.breakpoints()[0].condition.op == Compare::Ge && debugger.watchpoints()[0].last == 0x302 &&
+              debugger.watchpoints()[0].access == (ACCESS_READ | ACCESS_WRITE), "console sets points");
+        std::istringstream quit("step 2\nquit\n");
+        check(!console.run(quit, chip8, 0) && chip8.program_counter() == 0x204, "console steps and quits");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, "    LDV V0, 1\n    RET\n");
+        Debugger debugger;
+        debugger.add_breakpoint(0x300);
+        Stop stop = debugger.run(chip8, 100, 0);
+        check(stop.reason == StopReason::Fault && stop.steps == 2 && chip8.fault() == Fault::StackUnderflow,
+              "a fault stops the run");
+    }
+    return failures == 0 ? 0 : 1;
+}
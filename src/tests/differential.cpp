@@ -0,0 +1,269 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "analysis/analysis.hpp"
+#include "chip8/chip8.hpp"
+#include "instructions/decode.hpp"
+#include "utils/format.hpp"
+
+// Steps the reference engine and another engine in lockstep and stops at the first
+// instruction after which their machine states differ.
+
+#define DISASM_WINDOW 4 // Instructions shown either side of the divergence
+#define DIFF_SPILL_WORDS 16 // Words past the end of a random program that it may write and run
+
+static bool compare(const Chip8& ref, const Chip8& alt, std::string& what) {
+    if (ref.program_counter() != alt.program_counter()) {
+        what = fmt("pc %s != %s", hex(ref.program_counter(), 3), hex(alt.program_counter(), 3));
+    } else if (ref.index() != alt.index()) {
+        what = fmt("I %s != %s", hex(ref.index(), 3), hex(alt.index(), 3));
+    } else if (ref.stack_pointer() != alt.stack_pointer()) {
+        what = fmt("sp %s != %s", int(ref.stack_pointer()), int(alt.stack_pointer()));
+    } else if (ref.delay_timer() != alt.delay_timer() || ref.sound_timer() != alt.sound_timer()) {
+        what = fmt("timers dt=%s st=%s != dt=%s st=%s", int(ref.delay_timer()), int(ref.sound_timer()),
+                   int(alt.delay_timer()), int(alt.sound_timer()));
+    } else {
+        for (int i = 0; i < N_REG; i++) {
+            if (ref.registers()[i] != alt.registers()[i]) {
+                what = fmt("%s %s != %s", reg(i), hex(ref.registers()[i], 2), hex(alt.registers()[i], 2));
+                return false;
+            }
+        }
+        for (int i = 0; i < ref.stack_pointer(); i++) {
+            if (ref.call_stack()[i] != alt.call_stack()[i]) {
+                what = fmt("stack[%s] %s != %s", i, hex(ref.call_stack()[i], 3), hex(alt.call_stack()[i], 3));
+                return false;
+            }
+        }
+        if (memcmp(ref.ram(), alt.ram(), MEM_SIZE) != 0) {
+            for (int i = 0; i < MEM_SIZE; i++) {
+                if (ref.ram()[i] != alt.ram()[i]) {
+                    what = fmt("memory[%s] %s != %s", hex(i, 3), hex(ref.ram()[i], 2), hex(alt.ram()[i], 2));
+                    break;
+                }
+            }
+        } else if (ref.display_hash() != alt.display_hash()) {
+            what = "display differs";
+        } else if (ref.state_hash() != alt.state_hash()) {
+            what = "state hash differs";
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void disassemble_around(const Chip8& chip8, uint16_t at, std::ostream& out) {
+    int start = std::max<int>(MEM_START, at - DISASM_WINDOW * 2);
+    int end = std::min<int>(MEM_SIZE - 2, at + DISASM_WINDOW * 2);
+    for (int addr = start; addr <= end; addr += 2) {
+        inst_t op = (chip8.ram()[addr] << 8) | chip8.ram()[addr + 1];
+        DecodedInst inst(op);
+        out << (addr == at ? " -> " : "    ") << hex(addr, 3) << ": " << hex(op, 4) << " "
+            << inst.cmd() << " " << inst.arg() << "\n";
+    }
+}
+
+struct Result {
+    bool ok = true;
+    size_t steps = 0;
+};
+
+// Run both machines on `rom` for up to `max_steps` instructions with pseudo random keys
+static Result run_lockstep(const std::string& name, const std::vector<uint8_t>& rom, Engine engine,
+                           size_t max_steps, uint32_t seed) {
+    Result result;
+    Chip8 ref, alt;
+    if (!ref.loadRom(rom.data(), rom.size()) || !alt.loadRom(rom.data(), rom.size())) {
+        std::cout << "FAIL " << name << ": cannot load ROM\n";
+        result.ok = false;
+        return result;
+    }
+    ref.seed(seed);
+    alt.seed(seed);
+    alt.set_engine(engine);
+
+    std::mt19937 keys_rng(seed);
+    uint16_t keydown = 0;
+    for (; result.steps < max_steps && !ref.finished(); result.steps++) {
+        if (result.steps % TICKS_PER_FRAME == 0 && keys_rng() % 8 == 0) {
+            keydown = (keys_rng() % 2) ? static_cast<uint16_t>(1 << (keys_rng() % 16)) : 0;
+        }
+        uint16_t pc = ref.program_counter();
+        ref.step(keydown);
+        alt.step(keydown);
+
+        std::string what;
+        if (ref.fault_message() != alt.fault_message()) {
+            what = fmt("fault '%s' != '%s'", ref.fault_message(), alt.fault_message());
+        } else if (compare(ref, alt, what)) {
+            if (ref.fault() != Fault::None) break; // Both faulted the same way
+            continue;
+        }
+        std::cout << "DIVERGED " << name << " (" << engine_name(engine) << ") after " << result.steps + 1
+                  << " instructions: " << what << "\n";
+        disassemble_around(ref, pc, std::cout);
+        result.ok = false;
+        return result;
+    }
+    // Once wrong, the incremental hash stays wrong, so checking it at the end is enough
+    for (const Chip8* chip8 : {&ref, &alt}) {
+        if (chip8->state_hash() == chip8->full_state_hash()) continue;
+        std::cout << "DIVERGED " << name << " (" << engine_name(chip8->get_engine())
+                  << "): incremental state hash differs from a full rehash\n";
+        result.ok = false;
+    }
+    return result;
+}
+
+// Random but mostly well formed program: every word decodes to a known instruction and
+// jumps/calls land on instructions inside the program, which ends on a self jump. With
+// `spill`, every LDI and half of the jumps and calls target the bytes just past the
+// end instead, and STR and BCD are common, so the program writes code there and then runs
+// it, as it does when it falls off the end.
+static std::vector<uint8_t> random_program(std::mt19937& rng, bool spill) {
+    size_t n_words = 16 + rng() % 240;
+    std::vector<uint8_t> rom(n_words * 2);
+    const uint16_t end = static_cast<uint16_t>(MEM_START + n_words * 2);
+    for (size_t i = 0; i < n_words; i++) {
+        inst_t op;
+        do {
+            op = static_cast<inst_t>(rng());
+            uint8_t hi = op >> 12;
+            if (hi == 0x1 || hi == 0x2 || hi == 0xB) op = (op & 0xF000) | (MEM_START + (rng() % n_words) * 2);
+            if (hi == 0xA) op = 0xA000 | (rng() % (MEM_SIZE - 0x100));
+            if (spill && hi == 0xB) op = 0x1000 | (op & 0x0FFF); // Computed jumps spoil the analysis
+            if (spill && hi == 0xF && rng() % 2) op = (op & 0xFF00) | (rng() % 2 ? 0x55 : 0x33); // STR, BCD
+            if (spill && (hi == 0xA || ((hi == 0x1 || hi == 0x2) && rng() % 2 == 0))) {
+                op = (op & 0xF000) | (end + (rng() % DIFF_SPILL_WORDS) * 2);
+            }
+        } while (decode(op) == OpKind::Unknown);
+        rom[i * 2] = op >> 8;
+        rom[i * 2 + 1] = op & 0xFF;
+    }
+    if (!spill) { // End on a self jump, so only skips can leave the program
+        rom[n_words * 2 - 2] = 0x10 | (end - 2) >> 8;
+        rom[n_words * 2 - 1] = (end - 2) & 0xFF;
+    }
+    return rom;
+}
+
+// Programs Predecoded gets wrong, which the analysis must never accept. Compared on the
+// other engines with every run.
+static const std::vector<std::vector<uint8_t>> regressions = {
+    // Writes LDV V0, 0x42 and JP 0x302 to 0x300, past the end of the image, and jumps there
+    {0xA3, 0x00, 0x60, 0x60, 0x61, 0x42, 0x62, 0x13, 0x63, 0x02, 0xF3, 0x55, 0x13, 0x00},
+};
+
+static int usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--engine name] [--steps N] [--random N] [rom...]\n";
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<Engine> engines = {Engine::Switch, Engine::Predecoded};
+    size_t max_steps = 200000;
+    size_t n_random = 0;
+    std::vector<std::string> roms;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg != "--engine" && arg != "--steps" && arg != "--random") {
+            roms.push_back(arg);
+            continue;
+        }
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << arg << "\n";
+            return usage(argv[0]);
+        }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--engine") {
+                Engine e;
+                if (!parse_engine(value, e) || e == Engine::Reference) {
+                    std::cerr << "Unknown engine: " << value << "\n";
+                    return 1;
+                }
+                engines = {e};
+            } else if (arg == "--steps") {
+                max_steps = parse_count(value);
+            } else {
+                n_random = parse_count(value);
+            }
+        } catch (const std::logic_error&) {
+            std::cerr << "Bad value for " << arg << ": " << value << "\n";
+            return usage(argv[0]);
+        }
+    }
+    if (roms.empty() && n_random == 0) return usage(argv[0]);
+
+    // Both engines report unknown opcodes on stderr; that output is not what is being compared
+    std::ostringstream sink;
+    std::streambuf* cerr_buf = std::cerr.rdbuf(sink.rdbuf());
+
+    // Predecoded is only valid where the analysis proves it is; comparing it on those
+    // programs checks the analysis as much as the engine
+    auto skip = [](Engine engine, const std::vector<uint8_t>& rom) {
+        return engine == Engine::Predecoded && !analyze_program(rom.data(), rom.size()).predecode_safe();
+    };
+    int failures = 0;
+    size_t skipped = 0;
+    size_t total_steps = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < regressions.size(); i++) {
+        if (!analyze_program(regressions[i].data(), regressions[i].size()).predecode_safe()) continue;
+        std::cout << "FAIL regression #" << i << ": the analysis allows predecoded\n";
+        failures++;
+    }
+    for (Engine engine : engines) {
+        for (size_t i = 0; i < regressions.size(); i++) {
+            if (skip(engine, regressions[i])) {
+                skipped++;
+                continue;
+            }
+            Result r = run_lockstep(fmt("regression #%s", i), regressions[i], engine, max_steps, 1);
+            total_steps += r.steps;
+            failures += !r.ok;
+        }
+        for (const std::string& path : roms) {
+            std::ifstream in(path, std::ios::binary);
+            std::vector<uint8_t> rom((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (!in.eof() && !in) {
+                std::cout << "FAIL " << path << ": cannot read ROM\n";
+                failures++;
+                continue;
+            }
+            if (skip(engine, rom)) {
+                skipped++;
+                continue;
+            }
+            Result r = run_lockstep(path, rom, engine, max_steps, 1);
+            total_steps += r.steps;
+            failures += !r.ok;
+        }
+        std::mt19937 rng(12345);
+        for (size_t i = 0; i < n_random; i++) {
+            std::vector<uint8_t> rom = random_program(rng, i % 4 == 0);
+            if (skip(engine, rom)) {
+                skipped++;
+                continue;
+            }
+            Result r = run_lockstep(fmt("random #%s", i), rom, engine, 2000, static_cast<uint32_t>(i + 1));
+            total_steps += r.steps;
+            failures += !r.ok;
+            if (!r.ok) break;
+        }
+    }
+    std::cerr.rdbuf(cerr_buf);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << total_steps << " instructions compared in " << seconds << "s ("
+              << static_cast<size_t>(total_steps / std::max(seconds, 1e-9)) << "/s), "
+              << failures << " divergences, " << skipped << " programs skipped (not proven safe for predecoded)\n";
+    return failures == 0 ? 0 : 1;
+}
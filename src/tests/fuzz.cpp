@@ -0,0 +1,80 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "analysis/analysis.hpp"
+#include "chip8/chip8.hpp"
+
+// Fuzz target for the loader and every engine. Input layout: two bytes of keypad state
+// followed by the ROM image. Each engine runs the ROM for a fixed instruction budget and
+// the engines must end in the same state. Builds as a libFuzzer target with
+// -DCHIP8_FUZZ=ON (clang), otherwise as a driver that replays files or stdin (AFL).
+
+#define FUZZ_BUDGET 4096 // Instructions per engine per input
+#define FUZZ_ENGINES 3
+
+static Chip8 machines[FUZZ_ENGINES]; // Reused across inputs rather than constructed for each
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    // Unknown opcodes are reported on stderr by design; drop that output
+    std::cerr.rdbuf(nullptr);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size < 2) return 0;
+    uint16_t keydown = (data[0] << 8) | data[1];
+    data += 2;
+    size -= 2;
+    if (size > MEM_SIZE - MEM_START) size = MEM_SIZE - MEM_START;
+
+    // Predecoded runs wherever the analysis allows it, so a program it wrongly accepts
+    // fails like any other disagreement
+    const Engine engines[FUZZ_ENGINES] = {Engine::Reference, Engine::Switch, Engine::Predecoded};
+    const int n_engines = analyze_program(data, size).predecode_safe() ? 3 : 2;
+    for (int m = 0; m < n_engines; m++) {
+        Chip8& chip8 = machines[m];
+        chip8.set_engine(engines[m]);
+        chip8.loadRom(data, size); // Resets everything but the engine
+        for (int i = 0; i < FUZZ_BUDGET && !chip8.finished(); i++) chip8.step(keydown); // Stack faults halt, not a bug
+    }
+
+    const Chip8& a = machines[0];
+    for (int m = 1; m < n_engines; m++) {
+        const Chip8& b = machines[m];
+        if (a.halt() != b.halt() || a.fault() != b.fault() || a.fault_pc() != b.fault_pc() || a.program_counter() != b.program_counter() ||
+            a.index() != b.index() || a.stack_pointer() != b.stack_pointer() || memcmp(a.registers(), b.registers(), N_REG) != 0 ||
+            memcmp(a.ram(), b.ram(), MEM_SIZE) != 0 || a.display_hash() != b.display_hash()) {
+            fprintf(stderr, "Engines disagree on this input (%s)\n", engine_name(engines[m]));
+            abort();
+        }
+    }
+    return 0;
+}
+
+#ifndef CHIP8_LIBFUZZER
+int main(int argc, char* argv[]) {
+    LLVMFuzzerInitialize(&argc, &argv);
+    auto run = [](std::istream& in) {
+        std::vector<uint8_t> input((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    };
+    if (argc < 2) {
+        run(std::cin);
+    }
+    for (int i = 1; i < argc; i++) {
+        std::ifstream in(argv[i], std::ios::binary);
+        if (!in) {
+            fprintf(stderr, "Cannot open %s\n", argv[i]);
+            return 1;
+        }
+        run(in);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,148 @@
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "check.hpp"
+#include "debug/gdb_stub.hpp"
+
+// Scripted remote protocol client against a stub on an ephemeral localhost port and on a
+// Unix socket; no gdb needed
+class Client {
+private:
+    int fd;
+    std::string input;
+
+    char next() {
+        while (input.empty()) {
+            char buf[1024];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) throw std::runtime_error("connection closed");
+            input.append(buf, n);
+        }
+        char c = input[0];
+        input.erase(0, 1);
+        return c;
+    }
+
+public:
+    explicit Client(int fd): fd(fd) {}
+    ~Client() { close(fd); }
+
+    void raw(const std::string& bytes) {
+        if (write(fd, bytes.data(), bytes.size()) != static_cast<ssize_t>(bytes.size())) throw std::runtime_error("write failed");
+    }
+
+    void send(const std::string& payload) {
+        uint8_t sum = 0;
+        for (char c : payload) sum += static_cast<uint8_t>(c);
+        char tail[4];
+        snprintf(tail, sizeof(tail), "#%02x", sum);
+        raw("$" + payload + tail);
+    }
+
+    // Next packet, skipping acknowledgements
+    std::string reply() {
+        char c;
+        while ((c = next()) != '$') {}
+        std::string payload;
+        while ((c = next()) != '#') {
+            if (c == '}') c = next() ^ 0x20;
+            payload.push_back(c);
+        }
+        next();
+        next();
+        return payload;
+    }
+
+    std::string ask(const std::string& payload) {
+        send(payload);
+        return reply();
+    }
+};
+
+// V0 counts up forever and is stored with BCD at 0x300
+static const char* const counter =
+    "    LDI 0x300\n"
+    "    LDV V0, 0\n"
+    "loop:\n"
+    "    ADDV V0, 1\n"
+    "    BCD V0\n"
+    "    JP loop\n";
+
+static void session(Client& gdb, const std::string& transport) {
+    check(gdb.ask("qSupported:swbreak+").find("qXfer:features:read+") != std::string::npos, transport + " qSupported");
+    check(gdb.ask("QStartNoAckMode") == "OK", transport + " no-ack mode");
+    check(gdb.ask("qXfer:features:read:target.xml:0,fff").find("<reg name=\"pc\"") != std::string::npos,
+          transport + " target description");
+    check(gdb.ask("?") == "T05", transport + " halted on connect");
+
+    std::string regs = gdb.ask("g");
+    check(regs.size() == 23 * 2 && regs.substr(36, 4) == "0002", transport + " pc is 0x200 in g");
+    check(gdb.ask("p11") == "0002", transport + " pc through p");
+    check(gdb.ask("m200,4") == "a3006000", transport + " memory read");
+
+    check(gdb.ask("Z0,206,2") == "OK", transport + " set breakpoint");
+    check(gdb.ask("c") == "T05swbreak:;", transport + " continue to breakpoint");
+    check(gdb.ask("p11") == "0602", transport + " stopped at the breakpoint");
+    check(gdb.ask("c") == "T05swbreak:;" && gdb.ask("p0") == "02", transport + " loop hits it again");
+    check(gdb.ask("s") == "T05" && gdb.ask("p11") == "0802", transport + " single step");
+    check(gdb.ask("z0,206,2") == "OK", transport + " clear breakpoint");
+
+    check(gdb.ask("Z2,302,1") == "OK", transport + " set watchpoint");
+    check(gdb.ask("c") == "T05watch:302;" && gdb.ask("m302,1") == "03", transport + " continue to watchpoint");
+    check(gdb.ask("z2,302,1") == "OK", transport + " clear watchpoint");
+
+    gdb.send("c");
+    usleep(20000);
+    gdb.raw("\x03");
+    check(gdb.reply() == "T02", transport + " Ctrl-C stops a running target");
+    check(gdb.ask("M206,2:1206") == "OK" && gdb.ask("m206,2") == "1206", transport + " memory write");
+    check(gdb.ask("c") == "W00" && gdb.ask("p11") == "0602", transport + " a patched self jump halts the target");
+    check(gdb.ask("m1000,1") == "E01", transport + " out of range read");
+    check(gdb.ask("D") == "OK", transport + " detach");
+}
+
+int main() {
+    {
+        Chip8 chip8;
+        load(chip8, counter);
+        GdbStub stub(chip8, 0);
+        std::thread server([&] { stub.serve(); });
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(stub.port());
+        check(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0, "tcp connect");
+        {
+            Client gdb(fd);
+            session(gdb, "tcp");
+        }
+        server.join();
+    }
+    {
+        Chip8 chip8;
+        load(chip8, counter);
+        std::string path = "/tmp/chip8-gdb-test-" + std::to_string(getpid()) + ".sock";
+        GdbStub stub(chip8, path);
+        std::thread server([&] { stub.serve(); });
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        check(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0, "unix connect");
+        {
+            Client gdb(fd);
+            session(gdb, "unix");
+        }
+        server.join();
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cache/cache.hpp"
+#include "chip8/chip8.hpp"
+#include "chip8/input.hpp"
+#include "analysis/analysis.hpp"
+#include "rom/rom.hpp"
+#include "utils/format.hpp"
+
+// Golden display hashes for the ROMs in tests/. Each ROM runs headless for a fixed number
+// of frames with scripted keys and the final display must hash to the recorded value.
+// Regenerate a value with: headless <rom> --frames N --keys <script>
+struct RomCase {
+    const char* rom;
+    size_t frames;
+    const char* keys;
+    uint64_t display_hash;
+    Timing timing = Timing::Fixed;
+};
+
+static const RomCase cases[] = {
+    {"1-chip8-logo.ch8", 100, "", 0x413ced6d0e78c629ull},
+    {"2-ibm-logo.ch8", 100, "", 0x4869a244aa76d9adull},
+    {"3-corax+.ch8", 300, "", 0xc29d7deac71d44caull},
+    {"4-flags.ch8", 300, "", 0xe198c1c080e323e3ull},
+    {"5-quirks.ch8", 600, "100:0x0002,105:0", 0xd6832de194617fa1ull}, // Pick CHIP-8 in the menu
+    {"RPS.ch8", 300, "100:0x0010,104:0", 0xdc82aa590ed2cca8ull},
+    // Display wait passes only under VIP timing: one sprite per frame
+    {"5-quirks.ch8", 600, "100:0x0002,105:0", 0x1f0735fa1214696dull, Timing::Vip},
+};
+
+static const Engine engines[] = {Engine::Reference, Engine::Switch, Engine::Predecoded};
+
+static bool run_case(const std::string& dir, const RomCase& c, Engine engine, const ResultCache* cache,
+                     std::string& report) {
+    std::string label = engine_name(engine);
+    if (c.timing != Timing::Fixed) label = label + ", " + timing_name(c.timing);
+    std::unique_ptr<MappedRom> rom;
+    try {
+        rom = std::make_unique<MappedRom>(dir + "/" + c.rom);
+    } catch (const std::runtime_error&) {
+        report = fmt("FAIL %s [%s]: cannot load ROM", c.rom, label.c_str());
+        return false;
+    }
+    size_t size = std::min<size_t>(rom->size(), MEM_SIZE - MEM_START);
+    if (engine == Engine::Predecoded && !analyze_program(rom->data(), size).predecode_safe()) {
+        report = fmt("SKIP %s [%s]: not proven free of self-modifying code", c.rom, label.c_str());
+        return true;
+    }
+
+    RunKey key = run_key(rom->data(), size, c.keys, c.frames, 0, c.timing, engine);
+    RunResult result;
+    bool cached = cache && cache->lookup(key, result);
+    if (!cached) {
+        Chip8 chip8;
+        chip8.set_engine(engine);
+        chip8.set_timing(c.timing);
+        chip8.loadRom(rom->data(), size);
+        chip8.set_budget(0, c.frames);
+        InputScript input(c.keys);
+        for (size_t frame = 0; !chip8.finished(); frame++) {
+            chip8.run_frame(input.keys_at(frame));
+        }
+        result = run_result(chip8);
+        if (cache) cache->store(key, result);
+    }
+    if (result.fault) {
+        report = fmt("FAIL %s [%s]: %s at %s", c.rom, label.c_str(), fault_name(static_cast<Fault>(result.fault)),
+                     hex(result.fault_pc, 3));
+        return false;
+    }
+    if (result.display_hash != c.display_hash) {
+        report = fmt("FAIL %s [%s]: display hash %s, expected %s", c.rom, label.c_str(), hex(result.display_hash, 16),
+                     hex(c.display_hash, 16));
+        return false;
+    }
+    report = fmt(cached ? "PASS %s [%s] (cached)" : "PASS %s [%s]", c.rom, label.c_str());
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2 && !(argc == 4 && std::string(argv[2]) == "--cache")) {
+        std::cerr << "Usage: " << argv[0] << " <rom_dir> [--cache dir]\n";
+        return 1;
+    }
+    const std::string dir = argv[1];
+    std::unique_ptr<ResultCache> cache;
+    if (argc == 4) {
+        try {
+            cache = std::make_unique<ResultCache>(argv[3]);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+    const size_t n_roms = sizeof(cases) / sizeof(cases[0]);
+    const size_t n_engines = sizeof(engines) / sizeof(engines[0]);
+    const size_t n_cases = n_roms * n_engines;
+
+    // Every case is independent, run them all at once
+    std::vector<std::string> reports(n_cases);
+    std::vector<char> passed(n_cases);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < n_cases; i++) {
+        workers.emplace_back([&, i] {
+            passed[i] = run_case(dir, cases[i % n_roms], engines[i / n_roms], cache.get(), reports[i]);
+        });
+    }
+    for (std::thread& t : workers) t.join();
+
+    int failures = 0;
+    for (size_t i = 0; i < n_cases; i++) {
+        std::cout << reports[i] << "\n";
+        failures += !passed[i];
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "asm/assembler.hpp"
+#include "disasm/disasm.hpp"
+#include "rom/rom.hpp"
+
+// Disassembles every ROM in a directory and assembles the listing again. The result must
+// be the original image byte for byte, and every code address must map back to a line.
+static bool roundtrip(const std::string& path) {
+    MappedRom rom(path);
+    Disassembly disasm(rom.data(), rom.size());
+    std::ostringstream listing;
+    listing << "=== " << path << " ===\n";
+    disasm.write_listing(listing);
+    listing << "=== END ===\n";
+
+    Assembler assembler;
+    try {
+        assembler.assemble_source(listing.str(), path);
+        assembler.finish();
+    } catch (const AsmError& e) {
+        std::cout << "FAIL " << path << ": " << e.what() << "\n";
+        return false;
+    }
+    std::vector<uint8_t> image = assembler.image();
+    if (image.size() != rom.size() || !std::equal(image.begin(), image.end(), rom.data())) {
+        size_t i = 0;
+        while (i < image.size() && i < rom.size() && image[i] == rom.data()[i]) i++;
+        std::cout << "FAIL " << path << ": image differs at offset " << i << "\n";
+        return false;
+    }
+    for (const BasicBlock& b : disasm.blocks()) {
+        if (!assembler.source_map().find(static_cast<uint16_t>(b.start))) {
+            std::cout << "FAIL " << path << ": no source line for " << b.start << "\n";
+            return false;
+        }
+    }
+    std::cout << "PASS " << path << " (" << rom.size() << " bytes)\n";
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <rom_dir>\n";
+        return 1;
+    }
+    std::vector<std::string> roms;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+        if (entry.path().extension() == ".ch8") roms.push_back(entry.path().string());
+    }
+    if (roms.empty()) {
+        std::cerr << "No ROMs in " << argv[1] << "\n";
+        return 1;
+    }
+    int failures = 0;
+    for (const std::string& path : roms) failures += !roundtrip(path);
+    return failures == 0 ? 0 : 1;
+}
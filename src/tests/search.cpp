@@ -0,0 +1,127 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "check.hpp"
+#include "chip8/input.hpp"
+#include "search/search.hpp"
+
+// State-space search over a small combination lock
+
+// V0 counts the keys 3, 7, 5 pressed in order, then BCD writes it to 0x300
+static const char* const lock =
+    "    LDV V2, 3\n"
+    "    LDV V3, 7\n"
+    "    LDV V4, 5\n"
+    "start:\n"
+    "    LDV V0, 0\n"
+    "first:\n"
+    "    SKP V2\n"
+    "    JP first\n"
+    "    LDV V0, 1\n"
+    "second:\n"
+    "    SKNP V2\n"
+    "    JP second\n"
+    "    SKP V3\n"
+    "    JP second\n"
+    "    LDV V0, 2\n"
+    "third:\n"
+    "    SKNP V3\n"
+    "    JP third\n"
+    "    SKP V4\n"
+    "    JP third\n"
+    "    LDV V0, 3\n"
+    "    LDI 0x300\n"
+    "    BCD V0\n"
+    "done:\n"
+    "    JP done\n";
+
+static const std::vector<uint16_t> combination = {1 << 3, 1 << 7, 1 << 5};
+
+static SearchGoal opened() {
+    SearchGoal goal;
+    parse_goal_term("V0 == 3", goal);
+    return goal;
+}
+
+static bool replays(const std::string& script, size_t frames) {
+    Chip8 chip8;
+    load(chip8, lock);
+    InputScript input(script);
+    for (size_t frame = 0; frame < frames; frame++) chip8.run_frame(input.keys_at(frame));
+    return chip8.registers()[0] == 3;
+}
+
+int main() {
+    {
+        SearchGoal goal;
+        check(parse_goal_term("V3 == 5", goal) && goal.registers.size() == 1 && goal.registers[0].reg == 3 &&
+              goal.registers[0].value == 5, "register goal");
+        check(parse_goal_term("[0x300] >= 2", goal) && goal.memory.size() == 1 && goal.memory[0].addr == 0x300 &&
+              goal.memory[0].op == Compare::Ge && goal.memory[0].value == 2, "memory goal");
+        check(parse_goal_term("display 0x1234", goal) && goal.match_display && goal.display_hash == 0x1234, "display goal");
+        check(goal.terms() == 3, "terms add up");
+        check(!parse_goal_term("V3 5", goal) && !parse_goal_term("[0x300] == 256", goal) &&
+              !parse_goal_term("Q == 1", goal) && !parse_goal_term("V0 == 1 2", goal), "bad goals rejected");
+        check(plan_script({0, 2, 2, 0, 8}, 1) == "1:0x0002,3:0x0000,4:0x0008,5:0x0000", "plan script");
+        check(plan_script({2, 2}, 3) == "0:0x0002,6:0x0000", "plan script with held frames");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, lock);
+        SearchOptions options;
+        options.threads = 4;
+        options.max_depth = 6;
+        SearchResult result = search(chip8, opened(), options);
+        check(result.found && result.inputs == combination, "bfs finds the shortest combination");
+        check(result.depth == combination.size(), "bfs stops at the goal's depth");
+        check(result.unique <= result.expanded && result.unique < 20, "revisited states are deduplicated");
+        check(replays(plan_script(result.inputs, 1), result.inputs.size() + 1), "plan replays as an input script");
+
+        options.threads = 1;
+        SearchResult single = search(chip8, opened(), options);
+        check(single.found && single.inputs == combination && single.threads == 1, "single threaded bfs agrees");
+
+        SearchGoal memory;
+        parse_goal_term("[0x302] == 3", memory);
+        check(search(chip8, memory, options).found, "memory goal is reached");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, lock);
+        SearchOptions options;
+        options.strategy = SearchStrategy::Beam;
+        options.beam_width = 4;
+        options.max_depth = 6;
+        options.frames_per_action = 2;
+        SearchResult result = search(chip8, opened(), options);
+        check(result.found && result.inputs.size() == combination.size(), "beam search opens the lock");
+        check(replays(plan_script(result.inputs, 2), 2 * result.inputs.size() + 1), "beam plan replays");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, lock);
+        SearchOptions options;
+        options.strategy = SearchStrategy::Mcts;
+        options.threads = 2;
+        options.max_depth = 8;
+        options.iterations = 4000;
+        SearchResult result = search(chip8, opened(), options);
+        check(result.found && replays(plan_script(result.inputs, 1), result.inputs.size() + 1), "mcts opens the lock");
+    }
+    {
+        Chip8 chip8;
+        load(chip8, lock);
+        SearchOptions options;
+        options.max_depth = 2;
+        options.score_addr = 0x302;
+        SearchResult result = search(chip8, opened(), options);
+        check(!result.found && result.depth == 2, "depth limit is respected");
+        options.max_depth = 6;
+        options.max_states = 17;
+        options.threads = 2;
+        result = search(chip8, opened(), options);
+        check(!result.found && result.expanded >= 17 && result.expanded < 17 + 17 * 16, "state budget is respected");
+    }
+    std::cout << (failures ? "FAILED" : "OK") << "\n";
+    return failures ? 1 : 0;
+}